@@ -10,6 +10,7 @@ public class ZoneProjectTarget : TargetRules
 		Type = TargetType.Game;
 		DefaultBuildSettings = BuildSettingsVersion.V5;
 		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_4;
+		bWithPushModel = true;
 		ExtraModuleNames.Add("ZoneProject");
 	}
 }
@@ -0,0 +1,185 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#include "ZoneProjectRollingStatistics.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+BEGIN_DEFINE_SPEC(FZoneProjectRollingStatisticsSpec, "ZoneProject.RollingStatistics",
+	EAutomationTestFlags::ProductFilter | EAutomationTestFlags::ApplicationContextMask)
+
+	/* Values of the window computed by brute force, from the newest to the oldest */
+	TArray<double> Expected;
+
+	/* Feed @Num random samples and keep the latest @Capacity of them in @Expected */
+	void Feed(TRollingStatistics<float>& Statistics, const int32 Capacity, const int32 Num, FRandomStream& Random)
+	{
+		for (int32 Index = 0; Index < Num; ++Index)
+		{
+			const float Value = Random.FRandRange(-100.f, 100.f);
+
+			Statistics.Add(Value);
+
+			Expected.Insert(Value, 0);
+			if (Expected.Num() > Capacity) Expected.SetNum(Capacity);
+		}
+	}
+
+	/* Return the interpolated percentile of @Expected */
+	double ExpectedPercentile(const double Percentile) const
+	{
+		TArray<double> Sorted = Expected;
+		Sorted.Sort();
+
+		const double Rank = Percentile * (Sorted.Num() - 1);
+		const int32 Lower = FMath::FloorToInt32(Rank);
+		const int32 Upper = FMath::Min(Lower + 1, Sorted.Num() - 1);
+
+		return FMath::Lerp(Sorted[Lower], Sorted[Upper], Rank - Lower);
+	}
+
+END_DEFINE_SPEC(FZoneProjectRollingStatisticsSpec)
+
+void FZoneProjectRollingStatisticsSpec::Define()
+{
+	BeforeEach([this]()
+	{
+		Expected.Reset();
+	});
+
+	Describe("A partially filled window", [this]()
+	{
+		It("should report the statistics of the added samples", [this]()
+		{
+			TRollingStatistics<float> Statistics(64);
+			FRandomStream Random(1);
+
+			Feed(Statistics, 64, 10, Random);
+
+			TestEqual("Num", Statistics.Num(), 10);
+			TestEqual("Newest", static_cast<double>(Statistics.Last()), Expected[0]);
+			TestEqual("Oldest", static_cast<double>(Statistics[9]), Expected[9]);
+			TestEqual("Min", static_cast<double>(Statistics.GetMin()), FMath::Min(Expected));
+			TestEqual("Max", static_cast<double>(Statistics.GetMax()), FMath::Max(Expected));
+		});
+	});
+
+	Describe("A window that wrapped around", [this]()
+	{
+		It("should match the brute force statistics after every sample", [this]()
+		{
+			constexpr int32 Capacity = 17;
+
+			TRollingStatistics<float> Statistics(Capacity);
+			FRandomStream Random(2);
+
+			for (int32 Step = 0; Step < 200; ++Step)
+			{
+				Feed(Statistics, Capacity, 1, Random);
+
+				double Mean = 0.0;
+				for (const double Value : Expected) Mean += Value;
+				Mean /= Expected.Num();
+
+				double Variance = 0.0;
+				for (const double Value : Expected) Variance += FMath::Square(Value - Mean);
+				Variance /= Expected.Num();
+
+				if (!TestEqual("Mean", Statistics.GetMean(), Mean, 1e-6)) return;
+				if (!TestEqual("Variance", Statistics.GetVariance(), Variance, 1e-4)) return;
+				if (!TestEqual("Min", static_cast<double>(Statistics.GetMin()), FMath::Min(Expected))) return;
+				if (!TestEqual("Max", static_cast<double>(Statistics.GetMax()), FMath::Max(Expected))) return;
+			}
+		});
+
+		It("should interpolate the percentiles between the closest ranks", [this]()
+		{
+			constexpr int32 Capacity = 50;
+
+			TRollingStatistics<float> Statistics(Capacity);
+			FRandomStream Random(3);
+
+			Feed(Statistics, Capacity, 173, Random);
+
+			for (const double Percentile : { 0.0, 0.1, 0.5, 0.95, 0.99, 1.0 })
+			{
+				TestEqual(FString::Printf(TEXT("P%.0f"), Percentile * 100.0), Statistics.GetPercentile(Percentile), ExpectedPercentile(Percentile), 1e-4);
+			}
+		});
+
+		It("should track a monotonic sequence leaving the window", [this]()
+		{
+			TRollingStatistics<float> Statistics(4);
+
+			for (int32 Value = 0; Value < 10; ++Value) Statistics.Add(static_cast<float>(Value));
+
+			TestEqual("Min", Statistics.GetMin(), 6.f);
+			TestEqual("Max", Statistics.GetMax(), 9.f);
+
+			for (int32 Value = 10; Value > 0; --Value) Statistics.Add(static_cast<float>(Value));
+
+			TestEqual("Min after descending", Statistics.GetMin(), 1.f);
+			TestEqual("Max after descending", Statistics.GetMax(), 4.f);
+		});
+	});
+}
+
+BEGIN_DEFINE_SPEC(FZoneProjectRollingStatisticsBenchmark, "ZoneProject.RollingStatistics.Benchmark",
+	EAutomationTestFlags::PerfFilter | EAutomationTestFlags::ApplicationContextMask)
+END_DEFINE_SPEC(FZoneProjectRollingStatisticsBenchmark)
+
+void FZoneProjectRollingStatisticsBenchmark::Define()
+{
+	It("should sample faster than shifting an array", [this]()
+	{
+		constexpr int32 Capacity = 255;
+		constexpr int32 NumSamples = 1000000;
+
+		FRandomStream Random(4);
+
+		TArray<float> Input;
+		Input.SetNumUninitialized(NumSamples);
+		for (float& Value : Input) Value = Random.FRand();
+
+		// The previous history: insert at the front, trim the back and rescan for every statistic
+
+		double Checksum = 0.0;
+
+		double StartTime = FPlatformTime::Seconds();
+		{
+			TArray<float> Values;
+
+			for (const float Value : Input)
+			{
+				Values.Insert(Value, 0);
+				while (Values.Num() > Capacity) Values.RemoveAt(Capacity);
+
+				float Sum = 0.f;
+				for (const float Other : Values) Sum += Other;
+
+				Checksum += Sum / Values.Num() + FMath::Min(Values) + FMath::Max(Values);
+			}
+		}
+		const double ShiftingTime = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		{
+			TRollingStatistics<float> Statistics(Capacity);
+
+			for (const float Value : Input)
+			{
+				Statistics.Add(Value);
+
+				Checksum -= Statistics.GetMean() + Statistics.GetMin() + Statistics.GetMax();
+			}
+		}
+		const double RollingTime = FPlatformTime::Seconds() - StartTime;
+
+		AddInfo(FString::Printf(TEXT("%d samples, capacity %d: shifting array %.1f ms, rolling statistics %.1f ms (%.1fx), checksum %.3f"),
+			NumSamples, Capacity, ShiftingTime * 1000.0, RollingTime * 1000.0, ShiftingTime / FMath::Max(RollingTime, UE_SMALL_NUMBER), Checksum));
+
+		TestTrue("Rolling statistics are faster", RollingTime < ShiftingTime);
+	});
+}
+
+#endif
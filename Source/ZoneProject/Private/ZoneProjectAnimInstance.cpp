@@ -0,0 +1,45 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#include "ZoneProjectAnimInstance.h"
+#include "ZoneProjectCharacter.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+void UZoneProjectAnimInstance::NativeInitializeAnimation()
+{
+	Super::NativeInitializeAnimation();
+
+	Character = Cast<AZoneProjectCharacter>(TryGetPawnOwner());
+	Movement = Character ? Character->GetCharacterMovement() : nullptr;
+}
+
+void UZoneProjectAnimInstance::NativeUpdateAnimation(float DeltaSeconds)
+{
+	Super::NativeUpdateAnimation(DeltaSeconds);
+
+	// Reading the actor is only safe here, so copy everything the thread-safe update needs and nothing more
+
+	if (!Character || !Movement) return;
+
+	Velocity = Character->GetVelocity();
+	ActorRotation = Character->GetActorRotation();
+	AimRotation = Character->GetBaseAimRotation();
+
+	bIsAlive = Character->IsAlive();
+	bIsSprinting = Character->IsSprinting();
+	bIsFalling = Movement->IsFalling();
+}
+
+void UZoneProjectAnimInstance::NativeThreadSafeUpdateAnimation(float DeltaSeconds)
+{
+	Super::NativeThreadSafeUpdateAnimation(DeltaSeconds);
+
+	GroundSpeed = Velocity.Size2D();
+	bShouldMove = GroundSpeed > MinMoveSpeed && !bIsFalling;
+
+	Direction = GroundSpeed > MinMoveSpeed ? ActorRotation.UnrotateVector(Velocity).Rotation().Yaw : 0.f;
+
+	const FRotator AimDelta = (AimRotation - ActorRotation).GetNormalized();
+
+	AimPitch = AimDelta.Pitch;
+	AimYaw = AimDelta.Yaw;
+}
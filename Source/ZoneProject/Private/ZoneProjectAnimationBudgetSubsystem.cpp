@@ -0,0 +1,158 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#include "ZoneProjectAnimationBudgetSubsystem.h"
+#include "ZoneProject/ZoneProject.h"
+#include "ZoneProjectCharacter.h"
+#include "AnimationSharingManager.h"
+#include "AnimationSharingSetup.h"
+#include "IAnimationBudgetAllocator.h"
+#include "SkeletalMeshComponentBudgeted.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/World.h"
+
+void UZoneProjectAnimationBudgetSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// Nothing is rendered on a dedicated server, the update rate optimization alone keeps its animation cheap
+
+	if (InWorld.GetNetMode() == NM_DedicatedServer) return;
+
+	if (IAnimationBudgetAllocator* BudgetAllocator = IAnimationBudgetAllocator::Get(&InWorld))
+	{
+		BudgetAllocator->SetParameters(BudgetParameters);
+		BudgetAllocator->SetEnabled(bUseBudgetAllocator);
+	}
+
+	if (!SharingSetup.IsNull() && UAnimationSharingManager::AnimationSharingEnabled())
+	{
+		if (const UAnimationSharingSetup* Setup = SharingSetup.LoadSynchronous())
+		{
+			UAnimationSharingManager::CreateAnimationSharingManager(&InWorld, Setup);
+		}
+		else
+		{
+			UE_LOG(LogZoneProject, Warning, TEXT("Animation sharing setup %s could not be loaded"), *SharingSetup.ToString());
+		}
+	}
+}
+
+bool UZoneProjectAnimationBudgetSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UZoneProjectAnimationBudgetSubsystem::ApplyUpdateRateParameters(FAnimUpdateRateParameters* Parameters) const
+{
+	if (!Parameters) return;
+
+	if (UpdateRateScreenSizeThresholds.Num() > 0) Parameters->BaseVisibleDistanceFactorThesholds = UpdateRateScreenSizeThresholds;
+
+	Parameters->BaseNonRenderedUpdateRate = NonRenderedUpdateRate;
+	Parameters->MaxEvalRateForInterpolation = MaxEvalRateForInterpolation;
+}
+
+void UZoneProjectAnimationBudgetSubsystem::SetShared(ACharacter* Character, const bool bShared)
+{
+	if (IsShared(Character) == bShared) return;
+
+	UAnimationSharingManager* SharingManager = UAnimationSharingManager::GetAnimationSharingManager(GetWorld());
+	if (!SharingManager) return;
+
+	USkeletalMeshComponent* Mesh = Character->GetMesh();
+	const USkeletalMesh* SkeletalMesh = Mesh ? Mesh->GetSkeletalMeshAsset() : nullptr;
+	if (!SkeletalMesh) return;
+
+	// A shared mesh doesn't evaluate its own animation, so it must not take a slot of the budget
+
+	if (bShared)
+	{
+		SetBudgeted(Character, false);
+		SharingManager->RegisterActorWithSkeletonBP(Character, SkeletalMesh->GetSkeleton());
+		SharedCharacters.Add(Character);
+	}
+	else
+	{
+		SharingManager->UnregisterActor(Character);
+		SharedCharacters.Remove(Character);
+	}
+}
+
+void UZoneProjectAnimationBudgetSubsystem::SetBudgeted(ACharacter* Character, const bool bBudgeted) const
+{
+	USkeletalMeshComponentBudgeted* Mesh = Cast<USkeletalMeshComponentBudgeted>(Character->GetMesh());
+	if (!Mesh) return;
+
+	IAnimationBudgetAllocator* BudgetAllocator = IAnimationBudgetAllocator::Get(GetWorld());
+	if (!BudgetAllocator) return;
+
+	const bool bIsBudgeted = Mesh->GetAnimationBudgetHandle() != INDEX_NONE;
+
+	if (bBudgeted && !bIsBudgeted)
+	{
+		Mesh->SetAutoCalculateSignificance(true);
+		BudgetAllocator->RegisterComponent(Mesh);
+	}
+	else if (!bBudgeted && bIsBudgeted)
+	{
+		BudgetAllocator->UnregisterComponent(Mesh);
+	}
+}
+
+void UZoneProjectAnimationBudgetSubsystem::RegisterCharacter(ACharacter* Character)
+{
+	if (!Character || !Character->GetMesh()) return;
+
+	// Players keep a full rate animation on every machine
+
+	if (Character->IsPlayerControlled())
+	{
+		UnregisterCharacter(Character);
+		return;
+	}
+
+	USkeletalMeshComponent* Mesh = Character->GetMesh();
+	Mesh->bEnableUpdateRateOptimizations = true;
+
+	// The update rate manager creates the parameters and their tracker when the mesh registers with the optimization enabled.
+	// A mesh registered without it is registered again, ticking it without a tracker would assert
+
+	if (Mesh->AnimUpdateRateParams)
+	{
+		ApplyUpdateRateParameters(Mesh->AnimUpdateRateParams);
+	}
+	else
+	{
+		Mesh->OnAnimUpdateRateParamsCreated.BindUObject(this, &UZoneProjectAnimationBudgetSubsystem::ApplyUpdateRateParameters);
+
+		if (Mesh->IsRegistered()) Mesh->ReregisterComponent();
+	}
+
+	if (GetWorld()->GetNetMode() != NM_DedicatedServer && !IsShared(Character)) SetBudgeted(Character, true);
+}
+
+void UZoneProjectAnimationBudgetSubsystem::UnregisterCharacter(ACharacter* Character)
+{
+	if (!Character || !Character->GetMesh()) return;
+
+	SetShared(Character, false);
+	SetBudgeted(Character, false);
+
+	Character->GetMesh()->bEnableUpdateRateOptimizations = false;
+}
+
+void UZoneProjectAnimationBudgetSubsystem::UpdateSharing(ACharacter* Character, const int32 Bucket)
+{
+	if (!Character || Character->IsPlayerControlled()) return;
+
+	// Dying characters need their own pose for the death animation or the ragdoll
+
+	const AZoneProjectCharacter* ZoneCharacter = Cast<AZoneProjectCharacter>(Character);
+	const bool bCanShare = !ZoneCharacter || (ZoneCharacter->IsAlive() && !ZoneCharacter->IsDormant());
+
+	const bool bShared = bCanShare && Bucket >= SharingBucket;
+
+	SetShared(Character, bShared);
+
+	if (!bShared && bCanShare && GetWorld()->GetNetMode() != NM_DedicatedServer) SetBudgeted(Character, true);
+}
@@ -0,0 +1,34 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#include "ZoneProjectAnimationStateProcessor.h"
+#include "ZoneProject/ZoneProject.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+void UZoneProjectAnimationStateProcessor::ProcessActorState_Implementation(int32& OutState, AActor* InActor, uint8 CurrentState,
+	uint8 OnDemandState, bool& bShouldProcess)
+{
+	bShouldProcess = true;
+	OutState = static_cast<int32>(EAnimationSharingState::Idle);
+
+	const ACharacter* Character = Cast<ACharacter>(InActor);
+	if (!Character) return;
+
+	const UCharacterMovementComponent* Movement = Character->GetCharacterMovement();
+
+	if (Movement && Movement->IsFalling())
+	{
+		OutState = static_cast<int32>(EAnimationSharingState::Fall);
+		return;
+	}
+
+	const float Speed = Character->GetVelocity().Size2D();
+
+	if (Speed >= RunSpeed) OutState = static_cast<int32>(EAnimationSharingState::Run);
+	else if (Speed >= WalkSpeed) OutState = static_cast<int32>(EAnimationSharingState::Walk);
+}
+
+UEnum* UZoneProjectAnimationStateProcessor::GetAnimationStateEnum_Implementation()
+{
+	return StaticEnum<EAnimationSharingState>();
+}
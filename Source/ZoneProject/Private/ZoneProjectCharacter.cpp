@@ -1,21 +1,44 @@
 // Copyright Anton Romanov. All Rights Reserved.
 
 #include "ZoneProjectCharacter.h"
+#include "ZoneProjectAnimationBudgetSubsystem.h"
 #include "ZoneProjectCharacterMovement.h"
+#include "ZoneProjectController.h"
 #include "ZoneProjectDropItem.h"
+#include "ZoneProjectEnemyPoolSubsystem.h"
+#include "ZoneProjectHordeMovementSubsystem.h"
+#include "ZoneProjectLagCompensationSubsystem.h"
+#include "ZoneProjectNetTelemetrySubsystem.h"
+#include "ZoneProjectRagdollSubsystem.h"
+#include "ZoneProjectSignificanceSubsystem.h"
+#include "ZoneProjectSpatialHashSubsystem.h"
+#include "ZoneProjectTargetSubsystem.h"
 #include "ZoneProjectWeapon.h"
+#include "AIController.h"
+#include "BrainComponent.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
+#include "Engine/AssetManager.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/PlayerController.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "Engine/World.h"
+#include "GameFramework/DamageType.h"
+#include "Kismet/GameplayStatics.h"
 #include "Materials/Material.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "SkeletalMeshComponentBudgeted.h"
 #include "Net/UnrealNetwork.h"
 #include "UObject/ConstructorHelpers.h"
 
+const FPrimaryAssetType AZoneProjectCharacter::PrimaryAssetType = TEXT("Character");
+
+/* Time in seconds the height is sent with the planar movement after it last changed */
+static constexpr double PlanarHeightReplicationTime = 1.0;
+
 AZoneProjectCharacter::AZoneProjectCharacter(const FObjectInitializer& ObjectInitializer)
-    : Super(ObjectInitializer.SetDefaultSubobjectClass<UZoneProjectCharacterMovement>(ACharacter::CharacterMovementComponentName))
+    : Super(ObjectInitializer.SetDefaultSubobjectClass<UZoneProjectCharacterMovement>(ACharacter::CharacterMovementComponentName)
+		.SetDefaultSubobjectClass<USkeletalMeshComponentBudgeted>(ACharacter::MeshComponentName))
 {
 	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
 	
@@ -28,6 +51,14 @@ AZoneProjectCharacter::AZoneProjectCharacter(const FObjectInitializer& ObjectIni
 	GetCharacterMovement()->bConstrainToPlane = true;
 	GetCharacterMovement()->bSnapToPlaneAtStart = true;
 
+	// Only enemy meshes are budgeted, the animation budget subsystem registers them once the controller is known
+
+	CastChecked<USkeletalMeshComponentBudgeted>(GetMesh())->SetAutoRegisterWithBudgetAllocator(false);
+
+	// The update rate parameters are only created when the mesh registers with the optimization enabled, it is switched off later for players
+
+	GetMesh()->bEnableUpdateRateOptimizations = true;
+
 	// Create the camera boom component
 	
 	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
@@ -53,9 +84,58 @@ void AZoneProjectCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(AZoneProjectCharacter, MaxHealth);
-	DOREPLIFETIME(AZoneProjectCharacter, Health);
-	DOREPLIFETIME(AZoneProjectCharacter, Weapon);
+	// The state rarely changes, so it is only compared after being marked dirty
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AZoneProjectCharacter, ReplicatedHealth, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AZoneProjectCharacter, Weapon, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AZoneProjectCharacter, StateFlags, Params);
+
+	// Characters stay on the ground plane and only turn in yaw, the full 3D movement is replaced by the planar one
+
+	DISABLE_REPLICATED_PRIVATE_PROPERTY(AActor, ReplicatedMovement);
+	DOREPLIFETIME_CONDITION(AZoneProjectCharacter, PlanarMovement, COND_SimulatedOnly);
+}
+
+void AZoneProjectCharacter::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+	if (!IsReplicatingMovement()) return;
+
+	const FRepMovement& Movement = GetReplicatedMovement();
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	// The height is sent for a while after it changes, so connections updated less often than the server ticks still receive it
+
+	if (FMath::Abs(Movement.Location.Z - LastReplicatedZ) > 1.f || GetCharacterMovement()->IsFalling())
+	{
+		LastReplicatedZ = Movement.Location.Z;
+		LastZChangeTime = Now;
+	}
+
+	PlanarMovement.Location = Movement.Location;
+	PlanarMovement.Yaw = Movement.Rotation.Yaw;
+	PlanarMovement.Velocity = Movement.LinearVelocity;
+	PlanarMovement.bHasZ = LastZChangeTime >= 0.0 && Now - LastZChangeTime < PlanarHeightReplicationTime;
+}
+
+void AZoneProjectCharacter::OnRep_PlanarMovement()
+{
+	FRepMovement Movement = GetReplicatedMovement();
+
+	// Without a height the character keeps the one received with the spawn or the last change
+
+	Movement.Location = PlanarMovement.Location;
+	if (!PlanarMovement.bHasZ) Movement.Location.Z = GetActorLocation().Z;
+
+	Movement.Rotation = FRotator(0.f, PlanarMovement.Yaw, 0.f);
+	Movement.LinearVelocity = PlanarMovement.Velocity;
+
+	SetReplicatedMovement(Movement);
+	OnRep_ReplicatedMovement();
 }
 
 void AZoneProjectCharacter::PreInitializeComponents()
@@ -67,31 +147,105 @@ void AZoneProjectCharacter::PostInitializeComponents()
 {
 	Super::PostInitializeComponents();
 
-	if (HasAuthority())
+	if (HasAuthority() && !DefaultWeaponClass.IsNull())
 	{
-		if (DefaultWeaponClass)
-		{
-			FActorSpawnParameters SpawnInfo;
+		// The game mode preloads the weapon with the character class, a character spawned before that loads it in the background
 
-			SpawnInfo.Owner = this;
-			SpawnInfo.Instigator = this;
-			
-			SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-			
-			Weapon = GetWorld()->SpawnActor<AZoneProjectWeapon>(DefaultWeaponClass, GetActorTransform(), SpawnInfo);
-			
-			if (Weapon)
-			{
-				const FAttachmentTransformRules AttachmentRules(EAttachmentRule::SnapToTarget, true);
-				Weapon->AttachToComponent(GetMesh(), AttachmentRules, WeaponSocketName);
-			}
+		if (DefaultWeaponClass.Get())
+		{
+			SpawnDefaultWeapon();
 		}
+		else
+		{
+			UAssetManager::GetStreamableManager().RequestAsyncLoad(DefaultWeaponClass.ToSoftObjectPath(),
+				FStreamableDelegate::CreateUObject(this, &AZoneProjectCharacter::SpawnDefaultWeapon));
+		}
+	}
+}
+
+FPrimaryAssetId AZoneProjectCharacter::GetPrimaryAssetId() const
+{
+	return GetBlueprintPrimaryAssetId(this, PrimaryAssetType);
+}
+
+void AZoneProjectCharacter::GetContentPaths(TArray<FSoftObjectPath>& OutPaths) const
+{
+	if (!DefaultWeaponClass.IsNull()) OutPaths.AddUnique(DefaultWeaponClass.ToSoftObjectPath());
+
+	for (const FDropItemProbability& DropItemProbability : DropItemProbabilities)
+	{
+		if (!DropItemProbability.ItemClass.IsNull()) OutPaths.AddUnique(DropItemProbability.ItemClass.ToSoftObjectPath());
+	}
+}
+
+void AZoneProjectCharacter::SpawnDefaultWeapon()
+{
+	const TSubclassOf<AZoneProjectWeapon> WeaponClass = DefaultWeaponClass.Get();
+	if (!WeaponClass || Weapon || IsActorBeingDestroyed()) return;
+
+	FActorSpawnParameters SpawnInfo;
+
+	SpawnInfo.Owner = this;
+	SpawnInfo.Instigator = this;
+	
+	SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	
+	Weapon = GetWorld()->SpawnActor<AZoneProjectWeapon>(WeaponClass, GetActorTransform(), SpawnInfo);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AZoneProjectCharacter, Weapon, this);
+	
+	if (Weapon)
+	{
+		const FAttachmentTransformRules AttachmentRules(EAttachmentRule::SnapToTarget, true);
+		Weapon->AttachToComponent(GetMesh(), AttachmentRules, WeaponSocketName);
 	}
 }
 
 void AZoneProjectCharacter::BeginPlay()
 {
 	Super::BeginPlay();
+
+	// Record the hitbox history on the server for lag-compensated hit validation
+
+	if (HasAuthority())
+	{
+		UpdateReplicatedHealth();
+
+		if (UZoneProjectLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UZoneProjectLagCompensationSubsystem>())
+		{
+			LagCompensation->RegisterCharacter(this);
+		}
+
+		// Move the character as part of the horde while it is an AI far from the players
+
+		if (UZoneProjectHordeMovementSubsystem* HordeMovement = GetWorld()->GetSubsystem<UZoneProjectHordeMovementSubsystem>())
+		{
+			HordeMovement->RegisterCharacter(this);
+		}
+	}
+
+	// Throttle the ticks of the character by its distance to the players
+
+	if (UZoneProjectSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UZoneProjectSignificanceSubsystem>())
+	{
+		Significance->RegisterActor(this);
+	}
+
+	// Index the character for the proximity queries of the gameplay systems
+
+	if (!bIsDormant)
+	{
+		if (UZoneProjectSpatialHashSubsystem* SpatialHash = GetWorld()->GetSubsystem<UZoneProjectSpatialHashSubsystem>())
+		{
+			SpatialHash->RegisterActor(this, ESpatialCategory::Character, GetCapsuleComponent()->GetScaledCapsuleRadius());
+		}
+
+		// Cap the animation cost of the enemies
+
+		if (UZoneProjectAnimationBudgetSubsystem* AnimationBudget = GetWorld()->GetSubsystem<UZoneProjectAnimationBudgetSubsystem>())
+		{
+			AnimationBudget->RegisterCharacter(this);
+		}
+	}
 }
 
 void AZoneProjectCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
@@ -99,14 +253,141 @@ void AZoneProjectCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
 	if  (HasAuthority())
 	{
 		if (Weapon) Weapon->Destroy();
+
+		if (UZoneProjectLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UZoneProjectLagCompensationSubsystem>())
+		{
+			LagCompensation->UnregisterCharacter(this);
+		}
+
+		if (UZoneProjectHordeMovementSubsystem* HordeMovement = GetWorld()->GetSubsystem<UZoneProjectHordeMovementSubsystem>())
+		{
+			HordeMovement->UnregisterCharacter(this);
+		}
+	}
+
+	if (UZoneProjectSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UZoneProjectSignificanceSubsystem>())
+	{
+		Significance->UnregisterActor(this);
+	}
+
+	if (UZoneProjectSpatialHashSubsystem* SpatialHash = GetWorld()->GetSubsystem<UZoneProjectSpatialHashSubsystem>())
+	{
+		SpatialHash->UnregisterActor(this);
+	}
+
+	if (UZoneProjectAnimationBudgetSubsystem* AnimationBudget = GetWorld()->GetSubsystem<UZoneProjectAnimationBudgetSubsystem>())
+	{
+		AnimationBudget->UnregisterCharacter(this);
 	}
 	
 	Super::EndPlay(EndPlayReason);
 }
 
+void AZoneProjectCharacter::NotifyControllerChanged()
+{
+	Super::NotifyControllerChanged();
+
+	// The character may have become or stopped being a player
+
+	if (UZoneProjectAnimationBudgetSubsystem* AnimationBudget = GetWorld()->GetSubsystem<UZoneProjectAnimationBudgetSubsystem>())
+	{
+		if (bIsAlive && !bIsDormant) AnimationBudget->RegisterCharacter(this);
+	}
+}
+
+void AZoneProjectCharacter::OnRep_PlayerState()
+{
+	Super::OnRep_PlayerState();
+
+	// Remote players are only recognized once their player state arrives
+
+	if (UZoneProjectAnimationBudgetSubsystem* AnimationBudget = GetWorld()->GetSubsystem<UZoneProjectAnimationBudgetSubsystem>())
+	{
+		if (bIsAlive && !bIsDormant) AnimationBudget->RegisterCharacter(this);
+	}
+}
+
 void AZoneProjectCharacter::Tick(float DeltaSeconds)
 {
     Super::Tick(DeltaSeconds);
+
+	// Pick up the drop items touching the capsule
+
+	if (HasAuthority() && bIsAlive && IsPlayerControlled())
+	{
+		if (const UZoneProjectSpatialHashSubsystem* SpatialHash = GetWorld()->GetSubsystem<UZoneProjectSpatialHashSubsystem>())
+		{
+			TArray<AActor*> DropItems;
+			SpatialHash->QueryRadius(GetActorLocation(), GetCapsuleComponent()->GetScaledCapsuleRadius(), ESpatialCategory::DropItem, DropItems);
+
+			for (AActor* DropItem : DropItems)
+			{
+				CastChecked<AZoneProjectDropItem>(DropItem)->TryPickUp(this);
+			}
+		}
+	}
+}
+
+void AZoneProjectCharacter::SetHealth(const float Value)
+{
+	const float NewHealth = FMath::Clamp(Value, 0.f, MaxHealth);
+	if (NewHealth == Health) return;
+
+	Health = NewHealth;
+
+	if (HasAuthority()) UpdateReplicatedHealth();
+}
+
+void AZoneProjectCharacter::UpdateReplicatedHealth()
+{
+	ReplicatedHealth.Health = Health;
+	ReplicatedHealth.MaxHealth = MaxHealth;
+
+	MARK_PROPERTY_DIRTY_FROM_NAME(AZoneProjectCharacter, ReplicatedHealth, this);
+}
+
+void AZoneProjectCharacter::OnRep_ReplicatedHealth()
+{
+	MaxHealth = ReplicatedHealth.MaxHealth;
+	Health = ReplicatedHealth.Health;
+}
+
+void AZoneProjectCharacter::SetStateFlag(const ECharacterStateFlags Flag, const bool bEnabled)
+{
+	if (!HasAuthority() || HasStateFlag(Flag) == bEnabled) return;
+
+	ECharacterStateFlags Flags = static_cast<ECharacterStateFlags>(StateFlags);
+	if (bEnabled) EnumAddFlags(Flags, Flag); else EnumRemoveFlags(Flags, Flag);
+
+	StateFlags = static_cast<uint8>(Flags);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AZoneProjectCharacter, StateFlags, this);
+}
+
+void AZoneProjectCharacter::OnRep_StateFlags()
+{
+	// Late joiners receive the whole state at once, so every transition must be safe to apply from any local state
+
+	const bool bDormant = HasStateFlag(ECharacterStateFlags::Dormant);
+
+	if (bDormant != bIsDormant)
+	{
+		bIsDormant = bDormant;
+
+		if (!bIsDormant) ResetDeathState();
+		ApplyDormancy(bIsDormant);
+	}
+
+	const bool bDead = HasStateFlag(ECharacterStateFlags::Dead);
+
+	if (bDead && bIsAlive && !bIsDormant) InternalOnDeath();
+	else if (!bDead && !bIsAlive && !bIsDormant) ResetDeathState();
+
+	// The locally controlled character predicts its own sprint
+
+	if (!IsLocallyControlled())
+	{
+		if (HasStateFlag(ECharacterStateFlags::Sprinting)) Sprint(); else UnSprint();
+	}
 }
 
 float AZoneProjectCharacter::InternalTakePointDamage(float Damage, FPointDamageEvent const& PointDamageEvent,
@@ -114,7 +395,7 @@ float AZoneProjectCharacter::InternalTakePointDamage(float Damage, FPointDamageE
 {
 	SetHealth(Health - Damage);
 	
-	if (Health == 0.f) MulticastDeath();
+	if (Health == 0.f) InternalOnDeath();
 	
 	return Damage;
 }
@@ -125,10 +406,20 @@ void AZoneProjectCharacter::SpawnDropItem()
 	{
 		if (FMath::FRand() < DropItemProbability.Value)
 		{
+			// Drop items are preloaded by the game mode, one that isn't loaded is skipped rather than loaded synchronously
+
+			const TSubclassOf<AZoneProjectDropItem> ItemClass = DropItemProbability.ItemClass.Get();
+
+			if (!ItemClass)
+			{
+				UE_LOG(LogZoneProject, Warning, TEXT("Drop item %s of %s is not loaded"), *DropItemProbability.ItemClass.ToString(), *GetClass()->GetName());
+				continue;
+			}
+
 			FActorSpawnParameters SpawnInfo;
 			SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
 			
-			GetWorld()->SpawnActor<AZoneProjectDropItem>(DropItemProbability.ItemClass, GetActorTransform(), SpawnInfo);
+			GetWorld()->SpawnActor<AZoneProjectDropItem>(ItemClass, GetActorTransform(), SpawnInfo);
 			return;
 		}
 	}
@@ -136,14 +427,32 @@ void AZoneProjectCharacter::SpawnDropItem()
 
 void AZoneProjectCharacter::InternalOnDeath()
 {
+	if (!bIsAlive) return;
+
 	bIsAlive = false;
-	Health = 0.f;
+	SetHealth(0.f);
+	SetStateFlag(ECharacterStateFlags::Dead, true);
 	
 	GetCapsuleComponent()->SetCollisionProfileName(FName(TEXT("NoCollision")));
+
+	// Without collision the capsule has no floor, stop moving so a body that doesn't ragdoll stays where it died
+
+	GetCharacterMovement()->StopMovementImmediately();
+	GetCharacterMovement()->DisableMovement();
+
+	// The death pose is evaluated by the mesh itself
+
+	if (UZoneProjectAnimationBudgetSubsystem* AnimationBudget = GetWorld()->GetSubsystem<UZoneProjectAnimationBudgetSubsystem>())
+	{
+		AnimationBudget->UnregisterCharacter(this);
+	}
 		
-	// Enable ragdoll
-	GetMesh()->SetCollisionProfileName(FName(TEXT("Ragdoll")));
-	GetMesh()->SetAllBodiesSimulatePhysics(true);
+	// Enable ragdoll within the budget
+	
+	if (UZoneProjectRagdollSubsystem* Ragdolls = GetWorld()->GetSubsystem<UZoneProjectRagdollSubsystem>())
+	{
+		Ragdolls->StartDeathPose(this);
+	}
 
 	if (HasAuthority())
 	{
@@ -158,7 +467,152 @@ void AZoneProjectCharacter::InternalOnDeath()
 
 void AZoneProjectCharacter::RemoveCharacter()
 {
-	Destroy();
+	// Enemies go back to the pool, players are destroyed
+
+	UZoneProjectEnemyPoolSubsystem* EnemyPool = GetWorld()->GetSubsystem<UZoneProjectEnemyPoolSubsystem>();
+
+	if (EnemyPool && !IsPlayerControlled())
+	{
+		EnemyPool->ReleaseEnemy(this);
+	}
+	else
+	{
+		Destroy();
+	}
+}
+
+void AZoneProjectCharacter::ResetDeathState()
+{
+	const AZoneProjectCharacter* Defaults = GetClass()->GetDefaultObject<AZoneProjectCharacter>();
+
+	bIsAlive = true;
+	SetHealth(MaxHealth);
+
+	SetStateFlag(ECharacterStateFlags::Dead, false);
+	UnSprint();
+
+	GetCapsuleComponent()->SetCollisionProfileName(Defaults->GetCapsuleComponent()->GetCollisionProfileName());
+
+	// Disable ragdoll and put the mesh back under the capsule
+
+	if (UZoneProjectRagdollSubsystem* Ragdolls = GetWorld()->GetSubsystem<UZoneProjectRagdollSubsystem>())
+	{
+		Ragdolls->StopDeathPose(this);
+	}
+
+	USkeletalMeshComponent* CharacterMesh = GetMesh();
+
+	CharacterMesh->SetAllBodiesSimulatePhysics(false);
+	CharacterMesh->SetCollisionProfileName(Defaults->GetMesh()->GetCollisionProfileName());
+	CharacterMesh->AttachToComponent(GetCapsuleComponent(), FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+	CharacterMesh->SetRelativeLocationAndRotation(Defaults->GetMesh()->GetRelativeLocation(), Defaults->GetMesh()->GetRelativeRotation());
+
+	GetCharacterMovement()->SetMovementMode(GetCharacterMovement()->DefaultLandMovementMode);
+}
+
+void AZoneProjectCharacter::ApplyDormancy(const bool bDormant)
+{
+	// Take the mesh back from the budget allocator before it is disabled
+
+	UZoneProjectAnimationBudgetSubsystem* AnimationBudget = GetWorld()->GetSubsystem<UZoneProjectAnimationBudgetSubsystem>();
+	if (AnimationBudget && bDormant) AnimationBudget->UnregisterCharacter(this);
+
+	SetActorHiddenInGame(bDormant);
+	SetActorEnableCollision(!bDormant);
+	SetActorTickEnabled(!bDormant);
+
+	GetMesh()->SetComponentTickEnabled(!bDormant);
+
+	if (bDormant)
+	{
+		GetMesh()->SetAllBodiesSimulatePhysics(false);
+		GetCharacterMovement()->StopMovementImmediately();
+		GetCharacterMovement()->DisableMovement();
+	}
+
+	if (Weapon)
+	{
+		if (bDormant) Weapon->StopFire();
+		Weapon->SetActorHiddenInGame(bDormant);
+
+		// The weapon is dormant, send the new visibility once
+
+		if (HasAuthority()) Weapon->FlushNetDormancy();
+	}
+
+	// Dormant characters must not show up in proximity queries
+
+	if (UZoneProjectSpatialHashSubsystem* SpatialHash = GetWorld()->GetSubsystem<UZoneProjectSpatialHashSubsystem>())
+	{
+		if (bDormant)
+		{
+			SpatialHash->UnregisterActor(this);
+		}
+		else
+		{
+			SpatialHash->RegisterActor(this, ESpatialCategory::Character, GetCapsuleComponent()->GetScaledCapsuleRadius());
+		}
+	}
+
+	if (AnimationBudget && !bDormant) AnimationBudget->RegisterCharacter(this);
+}
+
+void AZoneProjectCharacter::EnterDormancy()
+{
+	if (!HasAuthority()) return;
+
+	GetWorldTimerManager().ClearTimer(RemoveTimer);
+
+	// Keep the controller possessing the character, only its logic is paused
+
+	if (AAIController* AIController = Cast<AAIController>(GetController()))
+	{
+		AIController->StopMovement();
+		if (UBrainComponent* Brain = AIController->GetBrainComponent()) Brain->StopLogic(TEXT("Dormant"));
+	}
+
+	// A pooled enemy must not keep using the budget of the shared target queries
+
+	if (UZoneProjectTargetSubsystem* Targets = GetWorld()->GetSubsystem<UZoneProjectTargetSubsystem>())
+	{
+		Targets->UnregisterQuerier(this);
+	}
+
+	bIsDormant = true;
+	SetStateFlag(ECharacterStateFlags::Dormant, true);
+
+	ApplyDormancy(true);
+
+	// The hidden state is sent before the channel goes dormant, after that the pooled character costs no bandwidth
+
+	SetNetDormancy(DORM_DormantAll);
+}
+
+void AZoneProjectCharacter::ExitDormancy(const FTransform& Transform)
+{
+	if (!HasAuthority()) return;
+
+	SetNetDormancy(DORM_Awake);
+
+	FVector Location = Transform.GetLocation();
+	FRotator Rotation = Transform.Rotator();
+
+	GetWorld()->FindTeleportSpot(this, Location, Rotation);
+	TeleportTo(Location, Rotation, false, true);
+
+	ResetDeathState();
+
+	bIsDormant = false;
+	SetStateFlag(ECharacterStateFlags::Dormant, false);
+
+	ApplyDormancy(false);
+
+	if (const AAIController* AIController = Cast<AAIController>(GetController()))
+	{
+		if (UBrainComponent* Brain = AIController->GetBrainComponent()) Brain->RestartLogic();
+	}
+
+	ForceNetUpdate();
 }
 
 FRotator AZoneProjectCharacter::GetBaseAimRotation() const
@@ -194,11 +648,15 @@ void AZoneProjectCharacter::Sprint()
 	if (CanSprint())
 	{
 		bIsSprinting = true;
+		SetStateFlag(ECharacterStateFlags::Sprinting, true);
 
 		if (UZoneProjectCharacterMovement* CharacterMovementCasted = Cast<UZoneProjectCharacterMovement>(GetCharacterMovement()))
 		{
 			CharacterMovementCasted->bOrientRotationToMovement = true;
-			if (IsLocallyControlled()) CharacterMovementCasted->bWantsToSprint = true;
+
+			// The movement speed follows the flag, the server takes it from the moves of remote players instead
+
+			if (!HasAuthority() || IsLocallyControlled()) CharacterMovementCasted->bWantsToSprint = true;
 		}
 	}
 }
@@ -206,20 +664,18 @@ void AZoneProjectCharacter::Sprint()
 void AZoneProjectCharacter::UnSprint()
 {
 	bIsSprinting = false;
+	SetStateFlag(ECharacterStateFlags::Sprinting, false);
 
 	if (UZoneProjectCharacterMovement* CharacterMovementCasted = Cast<UZoneProjectCharacterMovement>(GetCharacterMovement()))
 	{
 		CharacterMovementCasted->bOrientRotationToMovement = false;
-		if (IsLocallyControlled()) CharacterMovementCasted->bWantsToSprint = false;
+		if (!HasAuthority() || IsLocallyControlled()) CharacterMovementCasted->bWantsToSprint = false;
 	}
 }
 
 void AZoneProjectCharacter::StartFire()
 {
-	if (!bIsSprinting)
-	{
-		if (Weapon) Weapon->StartFire();
-	}
+	if (!bIsSprinting && Weapon) Weapon->StartFire();
 }
 
 void AZoneProjectCharacter::StopFire()
@@ -232,17 +688,40 @@ void AZoneProjectCharacter::SimulateFire(const FRotator Rotation)
 	if (Weapon) Weapon->SimulateFire(Rotation);
 }
 
-void AZoneProjectCharacter::MulticastDeath_Implementation()
+void AZoneProjectCharacter::ReportHit(AZoneProjectCharacter* Target, const FVector& Origin, const FVector& Direction)
 {
-	InternalOnDeath();
-}
+	if (!Target || !Target->IsAlive() || HasAuthority()) return;
 
-void AZoneProjectCharacter::ServerFire_Implementation()
-{
-	StartFire();
+	if (const AZoneProjectController* PlayerController = Cast<AZoneProjectController>(GetController()))
+	{
+		// The target is displayed one-way latency plus the proxy smoothing time behind the current server time
+
+		const float InterpolationDelay = Target->GetCharacterMovement()->NetworkSimulatedSmoothLocationTime;
+		const float Timestamp = PlayerController->GetServerTime() - PlayerController->GetRoundTrip() * 0.5f - InterpolationDelay;
+
+		ServerConfirmHit(Target, Timestamp, Origin, Direction);
+	}
 }
 
-void AZoneProjectCharacter::MulticastFire_Implementation(const FRotator Rotation)
+void AZoneProjectCharacter::ServerConfirmHit_Implementation(AZoneProjectCharacter* Target, float Timestamp, FVector_NetQuantize Origin,
+	FVector_NetQuantizeNormal Direction)
 {
-	if (GetLocalRole() == ROLE_SimulatedProxy) SimulateFire(Rotation);
+	UZoneProjectNetTelemetrySubsystem::RecordRpc(this, TEXT("ServerConfirmHit"));
+
+	if (!Weapon || !Target || Target == this || !Target->IsAlive() || !bIsAlive) return;
+
+	// A weapon can't hit more often than it fires
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	if (Now - LastHitConfirmTime < Weapon->GetFireRate() * 0.5f) return;
+
+	const UZoneProjectLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UZoneProjectLagCompensationSubsystem>();
+
+	if (LagCompensation && LagCompensation->ValidateHit(this, Target, Timestamp, Origin, Direction, Weapon->GetProjectileRange()))
+	{
+		LastHitConfirmTime = Now;
+
+		UGameplayStatics::ApplyPointDamage(Target, Weapon->GetProjectileDamage(), Direction, FHitResult(), GetController(), this,
+			UDamageType::StaticClass());
+	}
 }
@@ -13,42 +13,77 @@ UZoneProjectCharacterMovement::UZoneProjectCharacterMovement(const FObjectInitia
 
 	BrakingFrictionFactor = 1.f;
 	BrakingDecelerationWalking = 1000.f;
+
+	// Simulated proxies get planar 1 cm positions at the rate their significance allows, distant ones a few times per second
+	// Smooth over a little more than the default and snap sooner, a large error is a missed update rather than a small drift
+
+	NetworkSimulatedSmoothLocationTime = 0.12f;
+	NetworkSimulatedSmoothRotationTime = 0.06f;
+	ListenServerNetworkSimulatedSmoothLocationTime = 0.05f;
+	ListenServerNetworkSimulatedSmoothRotationTime = 0.05f;
+	NetworkMaxSmoothUpdateDistance = 192.f;
+	NetworkNoSmoothUpdateDistance = 320.f;
+
+	SetNetworkMoveDataContainer(MoveDataContainer);
 }
 
 float UZoneProjectCharacterMovement::GetMaxSpeed() const
 {
-	if (const AZoneProjectCharacter* CharacterCasted = Cast<AZoneProjectCharacter>(CharacterOwner))
-	{
-		if (IsWalking() && CharacterCasted->IsSprinting())
-		{
-			return SprintMaxWalkSpeed;
-		}
-	}
+	// Read the sprint flag of the move instead of the character state, so replayed moves use the speed they were made with
+
+	if ((IsWalking() || IsHordeMoving()) && bWantsToSprint) return SprintMaxWalkSpeed;
+
+	// Horde movement is kinematic walking
+
+	if (IsHordeMoving()) return MaxWalkSpeed;
 
 	return Super::GetMaxSpeed();
 }
 
 float UZoneProjectCharacterMovement::GetMaxAcceleration() const
 {
-	if (const AZoneProjectCharacter* CharacterCasted = Cast<AZoneProjectCharacter>(CharacterOwner))
+	if ((IsWalking() || IsHordeMoving()) && bWantsToSprint) return SprintMaxAcceleration;
+
+	return Super::GetMaxAcceleration();
+}
+
+void UZoneProjectCharacterMovement::UpdateClientAim(const FRotator& ControlRotation)
+{
+	const FRotator SentAim = FZoneProjectCharacterNetworkMoveData::DequantizeAim(PackedAimYaw, PackedAimPitch);
+
+	// Cursor jitter inside the deadband keeps the previous aim, so consecutive moves stay identical and can be combined
+
+	if (FMath::Abs(FRotator::NormalizeAxis(ControlRotation.Yaw - SentAim.Yaw)) > AimYawDeadband)
+	{
+		PackedAimYaw = FZoneProjectCharacterNetworkMoveData::QuantizeAimYaw(ControlRotation.Yaw);
+	}
+
+	if (FMath::Abs(FRotator::NormalizeAxis(ControlRotation.Pitch - SentAim.Pitch)) > AimPitchDeadband)
 	{
-		if (IsWalking() && CharacterCasted->IsSprinting())
+		PackedAimPitch = FZoneProjectCharacterNetworkMoveData::QuantizeAimPitch(ControlRotation.Pitch);
+	}
+}
+
+void UZoneProjectCharacterMovement::MoveAutonomous(float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags, const FVector& NewAccel)
+{
+	// The server takes the sprint state from the received move, clients replaying moves from the saved move in PrepMoveFor
+
+	if (CharacterOwner && CharacterOwner->HasAuthority())
+	{
+		if (const FZoneProjectCharacterNetworkMoveData* MoveData = static_cast<const FZoneProjectCharacterNetworkMoveData*>(GetCurrentNetworkMoveData()))
 		{
-			return SprintMaxAcceleration;
+			ApplySprint(MoveData->bWantsToSprint);
+			NumServerMoves++;
 		}
 	}
-	
-	return Super::GetMaxAcceleration();
+
+	Super::MoveAutonomous(ClientTimeStamp, DeltaTime, CompressedFlags, NewAccel);
 }
 
-void UZoneProjectCharacterMovement::UpdateFromCompressedFlags(uint8 Flags)
+void UZoneProjectCharacterMovement::ApplySprint(const bool bSprint)
 {
-	Super::UpdateFromCompressedFlags(Flags);
-
-	if (!CharacterOwner) return;
+	bWantsToSprint = bSprint;
 
-	bWantsToSprint = (Flags & FSavedMove_Character::FLAG_Custom_0) != 0;
-	
 	// Simulate actions on the server
 
 	if (CharacterOwner->HasAuthority())
@@ -60,6 +95,60 @@ void UZoneProjectCharacterMovement::UpdateFromCompressedFlags(uint8 Flags)
 	}
 }
 
+FVector UZoneProjectCharacterMovement::ConsumeHordeDesiredVelocity()
+{
+	// Path following either requests a velocity directly or adds input, depending on bUseAccelerationForPaths
+
+	FVector DesiredVelocity = ConsumeInputVector().GetClampedToMaxSize(1.f) * GetMaxSpeed();
+
+	if (bHasRequestedVelocity)
+	{
+		DesiredVelocity = RequestedVelocity.GetClampedToMaxSize(GetMaxSpeed());
+		bHasRequestedVelocity = false;
+	}
+
+	return DesiredVelocity;
+}
+
+void UZoneProjectCharacterMovement::OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode)
+{
+	Super::OnMovementModeChanged(PreviousMovementMode, PreviousCustomMode);
+
+	// The horde movement subsystem moves the character in a batch, the component doesn't need its own tick
+
+	if (CharacterOwner && CharacterOwner->HasAuthority())
+	{
+		SetComponentTickEnabled(!IsHordeMoving());
+	}
+}
+
+void UZoneProjectCharacterMovement::PhysCustom(float DeltaTime, int32 Iterations)
+{
+	// Horde movement is integrated by the horde movement subsystem
+
+	if (IsHordeMoving()) return;
+
+	Super::PhysCustom(DeltaTime, Iterations);
+}
+
+void UZoneProjectCharacterMovement::SendClientAdjustment()
+{
+	if (const FNetworkPredictionData_Server_Character* ServerData = HasPredictionData_Server() ? GetPredictionData_Server_Character() : nullptr)
+	{
+		if (ServerData->PendingAdjustment.TimeStamp > 0.f && !ServerData->PendingAdjustment.bAckGoodMove) NumCorrections++;
+	}
+
+	Super::SendClientAdjustment();
+}
+
+void UZoneProjectCharacterMovement::ConsumeNetStats(int32& OutMoves, int32& OutCorrections)
+{
+	OutMoves = NumServerMoves;
+	OutCorrections = NumCorrections;
+
+	NumServerMoves = NumCorrections = 0;
+}
+
 FNetworkPredictionData_Client* UZoneProjectCharacterMovement::GetPredictionData_Client() const
 {
 	if (ClientPredictionData == nullptr)
@@ -76,37 +165,48 @@ void FExtSavedMove_Character::Clear()
 	Super::Clear();
 
 	bWantsToSprint  = false;
+
+	PackedAimYaw = 0;
+	PackedAimPitch = 0;
 }
 
 void FExtSavedMove_Character::SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel, class FNetworkPredictionData_Client_Character& ClientData)
 {
 	Super::SetMoveFor(Character, InDeltaTime, NewAccel, ClientData);
 	
-	if (const UZoneProjectCharacterMovement* CharacterMovement = Cast<UZoneProjectCharacterMovement>(Character->GetCharacterMovement()))
+	if (UZoneProjectCharacterMovement* CharacterMovement = Cast<UZoneProjectCharacterMovement>(Character->GetCharacterMovement()))
 	{
 		bWantsToSprint  = CharacterMovement->bWantsToSprint;
+
+		CharacterMovement->UpdateClientAim(SavedControlRotation);
+
+		PackedAimYaw = CharacterMovement->GetPackedAimYaw();
+		PackedAimPitch = CharacterMovement->GetPackedAimPitch();
 	}
 }
 
 void FExtSavedMove_Character::PrepMoveFor(ACharacter* Character)
 {
 	Super::PrepMoveFor(Character);
+
+	if (UZoneProjectCharacterMovement* CharacterMovement = Cast<UZoneProjectCharacterMovement>(Character->GetCharacterMovement()))
+	{
+		CharacterMovement->bWantsToSprint = bWantsToSprint;
+	}
 }
 
 bool FExtSavedMove_Character::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* Character, float MaxDelta) const
 {
-	if (bWantsToSprint != ((FExtSavedMove_Character*)&NewMove)->bWantsToSprint) return false;
+	const FExtSavedMove_Character* NewMoveCasted = static_cast<const FExtSavedMove_Character*>(NewMove.Get());
 
-	return Super::CanCombineWith(NewMove, Character, MaxDelta);
-}
+	if (bWantsToSprint != NewMoveCasted->bWantsToSprint) return false;
 
-uint8 FExtSavedMove_Character::GetCompressedFlags() const
-{
-	uint8 Result = Super::GetCompressedFlags();
+	// Aim changes inside the deadband quantize to the same values. A larger change is sent right away,
+	// otherwise the server aim lags the cursor for shots fired before the combined move arrives
 
-	if (bWantsToSprint) Result |= FLAG_Custom_0;
+	if (PackedAimYaw != NewMoveCasted->PackedAimYaw || PackedAimPitch != NewMoveCasted->PackedAimPitch) return false;
 
-	return Result;
+	return Super::CanCombineWith(NewMove, Character, MaxDelta);
 }
 
 FExtNetworkPredictionData_Client_Character::FExtNetworkPredictionData_Client_Character
@@ -116,3 +216,102 @@ FSavedMovePtr FExtNetworkPredictionData_Client_Character::AllocateNewMove()
 {
 	return FSavedMovePtr(new FExtSavedMove_Character());
 }
+
+FZoneProjectCharacterNetworkMoveDataContainer::FZoneProjectCharacterNetworkMoveDataContainer()
+{
+	NewMoveData = &MoveData[0];
+	PendingMoveData = &MoveData[1];
+	OldMoveData = &MoveData[2];
+}
+
+void FZoneProjectCharacterNetworkMoveData::ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType)
+{
+	Super::ClientFillNetworkMoveData(ClientMove, MoveType);
+
+	const FExtSavedMove_Character& ClientMoveCasted = static_cast<const FExtSavedMove_Character&>(ClientMove);
+
+	bWantsToSprint = ClientMoveCasted.bWantsToSprint;
+	PackedAimYaw = ClientMoveCasted.PackedAimYaw;
+	PackedAimPitch = ClientMoveCasted.PackedAimPitch;
+}
+
+bool FZoneProjectCharacterNetworkMoveData::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType)
+{
+	NetworkMoveType = MoveType;
+
+	bool bLocalSuccess = true;
+
+	Ar << TimeStamp;
+
+	Acceleration.NetSerialize(Ar, PackageMap, bLocalSuccess);
+	Location.NetSerialize(Ar, PackageMap, bLocalSuccess);
+
+	// 23 bits of aim and sprint instead of up to 51 bits of control rotation, sprint no longer sets the compressed flags
+
+	uint8 bSprintBit = bWantsToSprint ? 1 : 0;
+	Ar.SerializeBits(&bSprintBit, 1);
+
+	Ar.SerializeInt(PackedAimYaw, 1 << AimYawBits);
+	Ar.SerializeInt(PackedAimPitch, 1 << AimPitchBits);
+
+	uint8 bHasFlags = CompressedMoveFlags != 0 ? 1 : 0;
+	Ar.SerializeBits(&bHasFlags, 1);
+
+	if (bHasFlags) Ar << CompressedMoveFlags; else CompressedMoveFlags = 0;
+
+	// Base and mode are only used for error checking, so only sent with the final move
+
+	if (MoveType == ENetworkMoveType::NewMove)
+	{
+		uint8 bHasBase = MovementBase != nullptr ? 1 : 0;
+		Ar.SerializeBits(&bHasBase, 1);
+
+		if (bHasBase)
+		{
+			Ar << MovementBase;
+			Ar << MovementBaseBoneName;
+		}
+		else
+		{
+			MovementBase = nullptr;
+			MovementBaseBoneName = NAME_None;
+		}
+
+		Ar << MovementMode;
+	}
+
+	if (Ar.IsLoading())
+	{
+		bWantsToSprint = bSprintBit != 0;
+		ControlRotation = DequantizeAim(PackedAimYaw, PackedAimPitch);
+	}
+
+	return !Ar.IsError();
+}
+
+uint32 FZoneProjectCharacterNetworkMoveData::QuantizeAimYaw(const float Yaw)
+{
+	constexpr int32 Steps = 1 << AimYawBits;
+
+	return static_cast<uint32>(FMath::RoundToInt32(FRotator::ClampAxis(Yaw) * Steps / 360.f)) & (Steps - 1);
+}
+
+uint32 FZoneProjectCharacterNetworkMoveData::QuantizeAimPitch(const float Pitch)
+{
+	constexpr int32 MaxStep = (1 << AimPitchBits) - 1;
+
+	const float Alpha = (FMath::Clamp(FRotator::NormalizeAxis(Pitch), -90.f, 90.f) + 90.f) / 180.f;
+
+	return static_cast<uint32>(FMath::RoundToInt32(Alpha * MaxStep));
+}
+
+FRotator FZoneProjectCharacterNetworkMoveData::DequantizeAim(const uint32 Yaw, const uint32 Pitch)
+{
+	constexpr int32 YawSteps = 1 << AimYawBits;
+	constexpr int32 MaxPitchStep = (1 << AimPitchBits) - 1;
+
+	return FRotator(
+		static_cast<float>(Pitch) * 180.f / MaxPitchStep - 90.f,
+		FRotator::NormalizeAxis(static_cast<float>(Yaw) * 360.f / YawSteps),
+		0.f);
+}
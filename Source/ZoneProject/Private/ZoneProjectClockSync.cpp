@@ -0,0 +1,164 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#include "ZoneProjectClockSync.h"
+
+/* Shortest time span of the samples the drift is estimated over, below it the offset is assumed constant */
+static constexpr double MinDriftSpan = 5.0;
+
+/* Weight of a new window sample in the smoothed round trip */
+static constexpr double RoundTripSmoothing = 0.25;
+
+void FZoneProjectClockSync::Reset()
+{
+	Samples.Reset();
+	WindowBest = FZoneProjectClockSample();
+	WindowCount = 0;
+	ProbesSent = 0;
+	RejectedSamples = 0;
+
+	FitTime = FitOffset = FitDrift = 0.0;
+	SmoothedOffset = 0.0;
+	LastUpdateTime = LastServerTime = 0.0;
+	RoundTrip = 0.0;
+
+	bSynchronized = false;
+}
+
+double FZoneProjectClockSync::ScheduleProbe()
+{
+	return ++ProbesSent < BurstProbeCount ? BurstProbeInterval : ProbeInterval;
+}
+
+void FZoneProjectClockSync::OnProbeAnswered(const double SendTime, const double ServerTime, const double ReceiveTime)
+{
+	if (ReceiveTime < SendTime) return;
+
+	// Assume the request and the answer took the same time, the error is at most half of the asymmetry
+
+	FZoneProjectClockSample Sample;
+	Sample.RoundTrip = ReceiveTime - SendTime;
+	Sample.LocalTime = (SendTime + ReceiveTime) * 0.5;
+	Sample.Offset = ServerTime - Sample.LocalTime;
+
+	// The first probe makes the clock usable right away, the connect burst refines it within a second
+
+	if (!bSynchronized)
+	{
+		FitTime = Sample.LocalTime;
+		FitOffset = SmoothedOffset = Sample.Offset;
+		FitDrift = 0.0;
+
+		RoundTrip = Sample.RoundTrip;
+		LastUpdateTime = ReceiveTime;
+
+		bSynchronized = true;
+	}
+
+	if (WindowCount == 0 || Sample.RoundTrip < WindowBest.RoundTrip) WindowBest = Sample;
+
+	if (++WindowCount >= WindowSize)
+	{
+		AddSample(WindowBest);
+		WindowCount = 0;
+	}
+}
+
+void FZoneProjectClockSync::AddSample(const FZoneProjectClockSample& Sample)
+{
+	if (Samples.Num() > 0)
+	{
+		double MinRoundTrip = Samples[0].RoundTrip;
+		for (const FZoneProjectClockSample& Other : Samples) MinRoundTrip = FMath::Min(MinRoundTrip, Other.RoundTrip);
+
+		// Even the best probe of the window was queued somewhere. Several in a row mean the route itself got slower
+
+		if (Sample.RoundTrip > MinRoundTrip * OutlierRoundTripFactor + OutlierRoundTripJitter)
+		{
+			if (++RejectedSamples < MaxRejectedSamples) return;
+
+			Samples.Reset();
+		}
+	}
+
+	RejectedSamples = 0;
+
+	Samples.Add(Sample);
+	if (Samples.Num() > MaxSamples) Samples.RemoveAt(0, Samples.Num() - MaxSamples, EAllowShrinking::No);
+
+	RoundTrip = Samples.Num() == 1 ? Sample.RoundTrip : FMath::Lerp(RoundTrip, Sample.RoundTrip, RoundTripSmoothing);
+
+	UpdateFit();
+}
+
+void FZoneProjectClockSync::UpdateFit()
+{
+	const int32 Num = Samples.Num();
+	if (Num == 0) return;
+
+	// Least squares line through the offsets, centered on the mean time to keep the sums well conditioned
+
+	double MeanTime = 0.0;
+	double MeanOffset = 0.0;
+
+	for (const FZoneProjectClockSample& Sample : Samples)
+	{
+		MeanTime += Sample.LocalTime;
+		MeanOffset += Sample.Offset;
+	}
+
+	MeanTime /= Num;
+	MeanOffset /= Num;
+
+	double Drift = 0.0;
+
+	if (Num >= 3 && Samples.Last().LocalTime - Samples[0].LocalTime >= MinDriftSpan)
+	{
+		double SumTimeTime = 0.0;
+		double SumTimeOffset = 0.0;
+
+		for (const FZoneProjectClockSample& Sample : Samples)
+		{
+			const double Time = Sample.LocalTime - MeanTime;
+
+			SumTimeTime += Time * Time;
+			SumTimeOffset += Time * (Sample.Offset - MeanOffset);
+		}
+
+		Drift = FMath::Clamp(SumTimeOffset / SumTimeTime, -MaxDrift, MaxDrift);
+	}
+
+	FitTime = MeanTime;
+	FitOffset = MeanOffset;
+	FitDrift = Drift;
+}
+
+void FZoneProjectClockSync::Update(const double LocalTime)
+{
+	if (!bSynchronized) return;
+
+	const double Elapsed = FMath::Max(LocalTime - LastUpdateTime, 0.0);
+	LastUpdateTime = LocalTime;
+
+	const double TargetOffset = FitOffset + FitDrift * (LocalTime - FitTime);
+	const double Error = TargetOffset - SmoothedOffset;
+
+	// Small errors are slewed so the clock stays continuous, large ones are stepped.
+	// A backward step holds the returned clock until the fit catches up with it
+
+	if (FMath::Abs(Error) > StepThreshold)
+	{
+		SmoothedOffset = TargetOffset;
+	}
+	else
+	{
+		const double MaxCorrection = MaxSlewRate * Elapsed;
+		SmoothedOffset += FMath::Clamp(Error, -MaxCorrection, MaxCorrection);
+	}
+
+	LastServerTime = FMath::Max(LastServerTime, LocalTime + SmoothedOffset);
+}
+
+double FZoneProjectClockSync::GetServerTime(const double LocalTime) const
+{
+	return FMath::Max(LastServerTime, LocalTime + SmoothedOffset);
+}
@@ -4,7 +4,11 @@
 #include "EnhancedInputComponent.h"
 #include "EnhancedInputSubsystems.h"
 #include "ZoneProjectCharacter.h"
+#include "ZoneProjectNetTelemetrySubsystem.h"
 #include "ZoneProjectWeapon.h"
+#include "Engine/Engine.h"
+#include "Misc/App.h"
+#include "GameFramework/GameStateBase.h"
 #include "Kismet/KismetMathLibrary.h"
 
 AZoneProjectController::AZoneProjectController()
@@ -17,14 +21,21 @@ void AZoneProjectController::BeginPlay()
 {
 	Super::BeginPlay();
 
-	FTimerManager& TimerManager = GetWorldTimerManager();
-	TimerManager.SetTimer(TimeSyncTimer, this, &AZoneProjectController::SyncTime, TimeSyncFrequency, true, 0.f);
+	// Only a client needs the server clock, start with a burst of probes
+
+	if (IsLocalController() && GetNetMode() == NM_Client)
+	{
+		ClockSync.Reset();
+		SyncTime();
+	}
 }
 
 void AZoneProjectController::Tick(float DeltaSeconds)
 {
 	Super::Tick(DeltaSeconds);
 
+	ClockSync.Update(FPlatformTime::Seconds());
+
 	if (IsLocalController() && ControlledCharacter)
 	{
 		const ETraceTypeQuery TraceChannel = UEngineTypes::ConvertToTraceType(ECC_Visibility);
@@ -99,9 +110,43 @@ void AZoneProjectController::AcknowledgePossession(APawn* InPawn)
 	}
 }
 
+float AZoneProjectController::GetSynchronizedTime(const UObject* WorldContextObject)
+{
+	const UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	if (!World) return 0.f;
+
+	if (World->GetNetMode() != NM_Client) return World->GetTimeSeconds();
+
+	if (const AZoneProjectController* PlayerController = Cast<AZoneProjectController>(World->GetFirstPlayerController()))
+	{
+		if (PlayerController->ClockSync.IsSynchronized()) return PlayerController->GetServerTime();
+	}
+
+	// Fall back to the coarse engine estimate until the first time sync completes
+
+	const AGameStateBase* GameState = World->GetGameState();
+	return GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+}
+
+float AZoneProjectController::GetServerTime() const
+{
+	return static_cast<float>(GetServerTimePrecise());
+}
+
+double AZoneProjectController::GetServerTimePrecise() const
+{
+	if (!ClockSync.IsSynchronized()) return GetWorld()->GetTimeSeconds();
+
+	return ClockSync.GetServerTime(FPlatformTime::Seconds());
+}
+
 void AZoneProjectController::SyncTime()
 {
-	ServerRequestTime(GetLocalTime());
+	// Probes are stamped with the platform clock, the world time only advances once per frame
+
+	ServerRequestTime(FPlatformTime::Seconds());
+
+	GetWorldTimerManager().SetTimer(TimeSyncTimer, this, &AZoneProjectController::SyncTime, ClockSync.ScheduleProbe(), false);
 }
 
 void AZoneProjectController::OnMoveTriggered(const FInputActionInstance& InputAction)
@@ -119,10 +164,7 @@ void AZoneProjectController::OnFireStarted(const FInputActionInstance& InputActi
 
 	if (ControlledCharacter)
 	{
-		if (AZoneProjectWeapon* Weapon = ControlledCharacter->GetWeapon())
-		{
-			Weapon->StartFire();
-		}
+		ControlledCharacter->StartFire();
 	}
 }
 
@@ -132,10 +174,7 @@ void AZoneProjectController::OnFireCompleted(const FInputActionInstance& InputAc
 
 	if (ControlledCharacter)
 	{
-		if (AZoneProjectWeapon* Weapon = ControlledCharacter->GetWeapon())
-		{
-			Weapon->StopFire();
-		}
+		ControlledCharacter->StopFire();
 	}
 }
 
@@ -159,40 +198,18 @@ void AZoneProjectController::OnSprintCompleted(const FInputActionInstance& Input
 	}
 }
 
-void AZoneProjectController::ServerRequestTime_Implementation(const float ClientTime)
-{
-	const float ServerTime = GetLocalTime();
-	ClientReportServerTime(ClientTime, ServerTime);
-}
-
-void AZoneProjectController::ClientReportServerTime_Implementation(const float ClientTime, float ServerTime)
+void AZoneProjectController::ServerRequestTime_Implementation(const double ClientTime)
 {
-	const float WorldTime = GetLocalTime();
-	const float RoundTrip = WorldTime - ClientTime;
-	const float Latency = RoundTrip * 0.5f;
+	UZoneProjectNetTelemetrySubsystem::RecordRpc(this, TEXT("ServerRequestTime"));
 
-	RoundTripHistory.Insert(RoundTrip);
-	RoundTripAverage = RoundTripHistory.Average();
+	// The world time was taken at the start of the frame, add the time spent in the frame so far
 
-	//UE_LOG(LogTemp, Warning, TEXT("SyncTime Result: Round Trip: %f; Round Trip Average: %f"), RoundTrip, RoundTripAverage);
+	const double ServerTime = GetWorld()->GetTimeSeconds() + (FPlatformTime::Seconds() - FApp::GetCurrentTime());
 
-	if (RoundTrip <= RoundTripThreshold)
-	{
-		const float TimeDelta = (ServerTime - WorldTime) + Latency;
-
-		TimeDeltaHistory.Insert(TimeDelta);
-		TimeDeltaAverage = TimeDeltaHistory.Average();
-
-		bTimeSyncLastStatus = bHasSyncedTime = true;
-		TimeSyncErrorCount = 0;
-
-		//UE_LOG(LogTemp, Warning, TEXT("SyncTime Result: Time Delta: %f; Time Delta Average: %f"), TimeDelta, TimeDeltaAverage);
-	}
-	else
-	{
-		bTimeSyncLastStatus = false;
-		TimeSyncErrorCount++;
+	ClientReportServerTime(ClientTime, ServerTime);
+}
 
-		//UE_LOG(LogTemp, Warning, TEXT("SyncTime Result: Round trip has exceeded the threshold: %f"), RoundTripThreshold);
-	}
+void AZoneProjectController::ClientReportServerTime_Implementation(const double ClientTime, const double ServerTime)
+{
+	ClockSync.OnProbeAnswered(ClientTime, ServerTime, FPlatformTime::Seconds());
 }
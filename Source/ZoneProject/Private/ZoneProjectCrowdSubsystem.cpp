@@ -0,0 +1,214 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#include "ZoneProjectCrowdSubsystem.h"
+#include "ZoneProject/ZoneProject.h"
+#include "ZoneProjectCharacter.h"
+#include "ZoneProjectEnemyPoolSubsystem.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+DECLARE_CYCLE_STAT(TEXT("Simulate Crowd"), STAT_ZoneProjectSimulateCrowd, STATGROUP_ZoneProject);
+DECLARE_CYCLE_STAT(TEXT("Promote Crowd"), STAT_ZoneProjectPromoteCrowd, STATGROUP_ZoneProject);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Crowd Entities"), STAT_ZoneProjectCrowdEntities, STATGROUP_ZoneProject);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Crowd Characters"), STAT_ZoneProjectCrowdCharacters, STATGROUP_ZoneProject);
+
+void UZoneProjectCrowdSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (GetWorld()->GetNetMode() == NM_Client) return;
+
+	SET_DWORD_STAT(STAT_ZoneProjectCrowdEntities, Positions.Num());
+	SET_DWORD_STAT(STAT_ZoneProjectCrowdCharacters, Promoted.Num());
+
+	PlayerLocations.Reset();
+
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController* PlayerController = Iterator->Get();
+		const APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+
+		if (Pawn) PlayerLocations.Add(Pawn->GetActorLocation());
+	}
+
+	if (Positions.Num() > 0)
+	{
+		SimulateEntities(DeltaTime);
+		PromoteEntities();
+	}
+
+	if (Promoted.Num() > 0)
+	{
+		DemoteCharacters();
+	}
+}
+
+TStatId UZoneProjectCrowdSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UZoneProjectCrowdSubsystem, STATGROUP_ZoneProject);
+}
+
+bool UZoneProjectCrowdSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UZoneProjectCrowdSubsystem::SpawnEnemy(TSubclassOf<AZoneProjectCharacter> EnemyClass, const FTransform& Transform)
+{
+	if (!EnemyClass || GetWorld()->GetNetMode() == NM_Client) return;
+
+	const FVector Location = Transform.GetLocation();
+	const float Health = GetDefault<AZoneProjectCharacter>(EnemyClass)->GetMaxHealth();
+
+	if (GetNearestPlayerDistanceSquared(Location) < FMath::Square(PromotionRadius))
+	{
+		PromoteEntity(EnemyClass, Location, Health);
+	}
+	else
+	{
+		AddEntity(EnemyClass, Location, Health);
+	}
+}
+
+void UZoneProjectCrowdSubsystem::AddEntity(TSubclassOf<AZoneProjectCharacter> EnemyClass, const FVector& Location, const float Health)
+{
+	const AZoneProjectCharacter* Defaults = GetDefault<AZoneProjectCharacter>(EnemyClass);
+
+	Positions.Add(Location);
+	Healths.Add(Health);
+	Speeds.Add(Defaults->GetCharacterMovement()->MaxWalkSpeed);
+	Targets.Add(INDEX_NONE);
+	States.Add(EEntityState::Idle);
+	TargetDistancesSquared.Add(TNumericLimits<float>::Max());
+	Classes.Add(EnemyClass);
+}
+
+void UZoneProjectCrowdSubsystem::RemoveEntityAtSwap(const int32 Index)
+{
+	Positions.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Healths.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Speeds.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Targets.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	States.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	TargetDistancesSquared.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Classes.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+}
+
+float UZoneProjectCrowdSubsystem::GetNearestPlayerDistanceSquared(const FVector& Location) const
+{
+	float MinDistanceSquared = TNumericLimits<float>::Max();
+
+	for (const FVector& PlayerLocation : PlayerLocations)
+	{
+		MinDistanceSquared = FMath::Min(MinDistanceSquared, FVector::DistSquared2D(Location, PlayerLocation));
+	}
+
+	return MinDistanceSquared;
+}
+
+void UZoneProjectCrowdSubsystem::SimulateEntities(const float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectSimulateCrowd);
+
+	// Entities walk straight towards the nearest player, the full characters take over pathfinding once they are promoted
+
+	ParallelFor(TEXT("ZoneProjectCrowd"), Positions.Num(), ParallelBatchSize, [this, DeltaTime](const int32 Index)
+	{
+		const FVector Position = Positions[Index];
+
+		int32 Target = INDEX_NONE;
+		float TargetDistanceSquared = TNumericLimits<float>::Max();
+
+		for (int32 Player = 0; Player < PlayerLocations.Num(); ++Player)
+		{
+			const float DistanceSquared = FVector::DistSquared2D(Position, PlayerLocations[Player]);
+
+			if (DistanceSquared < TargetDistanceSquared)
+			{
+				Target = Player;
+				TargetDistanceSquared = DistanceSquared;
+			}
+		}
+
+		Targets[Index] = Target;
+		States[Index] = Target != INDEX_NONE ? EEntityState::Chase : EEntityState::Idle;
+
+		if (States[Index] == EEntityState::Chase)
+		{
+			const FVector Direction = (PlayerLocations[Target] - Position).GetSafeNormal2D();
+			const float Step = FMath::Min(Speeds[Index] * DeltaTime, FMath::Sqrt(TargetDistanceSquared));
+
+			Positions[Index] = Position + Direction * Step;
+			TargetDistanceSquared = FVector::DistSquared2D(Positions[Index], PlayerLocations[Target]);
+		}
+
+		TargetDistancesSquared[Index] = TargetDistanceSquared;
+	});
+}
+
+AZoneProjectCharacter* UZoneProjectCrowdSubsystem::PromoteEntity(TSubclassOf<AZoneProjectCharacter> EnemyClass, const FVector& Location,
+	const float Health)
+{
+	UZoneProjectEnemyPoolSubsystem* EnemyPool = GetWorld()->GetSubsystem<UZoneProjectEnemyPoolSubsystem>();
+	if (!EnemyPool) return nullptr;
+
+	AZoneProjectCharacter* Character = EnemyPool->AcquireEnemy(EnemyClass, FTransform(Location));
+	if (!Character) return nullptr;
+
+	Character->SetHealth(Health);
+	Promoted.Add(Character);
+
+	return Character;
+}
+
+void UZoneProjectCrowdSubsystem::PromoteEntities()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectPromoteCrowd);
+
+	int32 Budget = MaxPromotionsPerFrame;
+
+	// Iterate backwards so swap-removal doesn't skip elements
+
+	for (int32 Index = Positions.Num() - 1; Index >= 0 && Budget > 0; --Index)
+	{
+		if (TargetDistancesSquared[Index] >= FMath::Square(PromotionRadius)) continue;
+
+		if (PromoteEntity(Classes[Index], Positions[Index], Healths[Index]))
+		{
+			RemoveEntityAtSwap(Index);
+			Budget--;
+		}
+	}
+}
+
+void UZoneProjectCrowdSubsystem::DemoteCharacters()
+{
+	int32 Budget = MaxDemotionsPerFrame;
+
+	UZoneProjectEnemyPoolSubsystem* EnemyPool = GetWorld()->GetSubsystem<UZoneProjectEnemyPoolSubsystem>();
+
+	for (int32 Index = Promoted.Num() - 1; Index >= 0; --Index)
+	{
+		AZoneProjectCharacter* Character = Promoted[Index].Get();
+
+		// Dead and pooled characters are no longer part of the crowd
+
+		if (!Character || !Character->IsAlive() || Character->IsDormant())
+		{
+			Promoted.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+			continue;
+		}
+
+		if (Budget <= 0 || !EnemyPool) continue;
+
+		const FVector Location = Character->GetActorLocation();
+		if (GetNearestPlayerDistanceSquared(Location) <= FMath::Square(DemotionRadius)) continue;
+
+		AddEntity(Character->GetClass(), Location, Character->GetHealth());
+		EnemyPool->ReleaseEnemy(Character);
+
+		Promoted.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+		Budget--;
+	}
+}
@@ -2,10 +2,26 @@
 
 #include "ZoneProjectDropItem.h"
 #include "ZoneProjectCharacter.h"
+#include "ZoneProjectSpatialHashSubsystem.h"
+#include "Engine/World.h"
+
+const FPrimaryAssetType AZoneProjectDropItem::PrimaryAssetType = TEXT("DropItem");
 
 AZoneProjectDropItem::AZoneProjectDropItem()
 {
-	PrimaryActorTick.bCanEverTick = true;
+	// Drop items are picked up by the characters querying the spatial hash
+
+	PrimaryActorTick.bCanEverTick = false;
+
+	// Drop items never change, they only replicate once to every connection that comes near
+
+	bReplicates = true;
+	NetDormancy = DORM_Initial;
+}
+
+FPrimaryAssetId AZoneProjectDropItem::GetPrimaryAssetId() const
+{
+	return GetBlueprintPrimaryAssetId(this, PrimaryAssetType);
 }
 
 void AZoneProjectDropItem::BeginPlay()
@@ -14,26 +30,39 @@ void AZoneProjectDropItem::BeginPlay()
 
 	if (HasAuthority())
 	{
-		OnActorBeginOverlap.AddDynamic(this, &AZoneProjectDropItem::OnBeginOverlap);
+		if (UZoneProjectSpatialHashSubsystem* SpatialHash = GetWorld()->GetSubsystem<UZoneProjectSpatialHashSubsystem>())
+		{
+			// Keep the pickup extent of the item collision unless the radius is set explicitly
+
+			const float Radius = PickupRadius > 0.f ? PickupRadius : GetSimpleCollisionRadius();
+			SpatialHash->RegisterActor(this, ESpatialCategory::DropItem, Radius, true);
+		}
 	}
 }
 
-void AZoneProjectDropItem::Tick(float DeltaTime)
+void AZoneProjectDropItem::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::Tick(DeltaTime);
+	if (HasAuthority())
+	{
+		if (UZoneProjectSpatialHashSubsystem* SpatialHash = GetWorld()->GetSubsystem<UZoneProjectSpatialHashSubsystem>())
+		{
+			SpatialHash->UnregisterActor(this);
+		}
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
-void AZoneProjectDropItem::OnBeginOverlap(AActor* OverlappedActor, AActor* OtherActor)
+bool AZoneProjectDropItem::TryPickUp(AZoneProjectCharacter* Character)
 {
-	if (AZoneProjectCharacter* Character = Cast<AZoneProjectCharacter>(OtherActor))
+	if (!Character || !Character->IsPlayerControlled() || IsActorBeingDestroyed()) return false;
+
+	if (Type == EDropItemType::Health)
 	{
-		if (Character->IsPlayerControlled())
-		{
-			if (Type == EDropItemType::Health)
-			{
-				Character->AddHealth(Amount);
-				Destroy();
-			}
-		}
+		Character->AddHealth(Amount);
+		Destroy();
+		return true;
 	}
+
+	return false;
 }
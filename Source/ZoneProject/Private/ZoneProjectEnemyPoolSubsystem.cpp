@@ -0,0 +1,118 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#include "ZoneProjectEnemyPoolSubsystem.h"
+#include "ZoneProject/ZoneProject.h"
+#include "ZoneProjectCharacter.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Acquire Enemy"), STAT_ZoneProjectAcquireEnemy, STATGROUP_ZoneProject);
+DECLARE_CYCLE_STAT(TEXT("Release Enemy"), STAT_ZoneProjectReleaseEnemy, STATGROUP_ZoneProject);
+
+static FAutoConsoleCommandWithWorld GEnemyPoolStatsCommand(
+	TEXT("ZoneProject.Enemies.PoolStats"),
+	TEXT("Print hits, misses and size of every enemy pool in the current world"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UZoneProjectEnemyPoolSubsystem* Subsystem = World ? World->GetSubsystem<UZoneProjectEnemyPoolSubsystem>() : nullptr)
+		{
+			Subsystem->DumpStats();
+		}
+	}));
+
+void UZoneProjectEnemyPoolSubsystem::Deinitialize()
+{
+	DumpStats();
+
+	Pools.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UZoneProjectEnemyPoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+AZoneProjectCharacter* UZoneProjectEnemyPoolSubsystem::SpawnEnemy(TSubclassOf<AZoneProjectCharacter> EnemyClass, const FTransform& Transform) const
+{
+	FActorSpawnParameters SpawnInfo;
+	SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	return GetWorld()->SpawnActor<AZoneProjectCharacter>(EnemyClass, Transform, SpawnInfo);
+}
+
+void UZoneProjectEnemyPoolSubsystem::WarmUp(TSubclassOf<AZoneProjectCharacter> EnemyClass, int32 Count)
+{
+	if (!EnemyClass || GetWorld()->GetNetMode() == NM_Client) return;
+
+	FEnemyPool& Pool = Pools.FindOrAdd(EnemyClass);
+
+	Count = FMath::Min(Count, MaxDormantEnemies);
+
+	while (Pool.Available.Num() < Count)
+	{
+		AZoneProjectCharacter* Enemy = SpawnEnemy(EnemyClass, FTransform::Identity);
+		if (!Enemy) break;
+
+		Enemy->EnterDormancy();
+		Pool.Available.Add(Enemy);
+	}
+}
+
+AZoneProjectCharacter* UZoneProjectEnemyPoolSubsystem::AcquireEnemy(TSubclassOf<AZoneProjectCharacter> EnemyClass, const FTransform& Transform)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectAcquireEnemy);
+
+	if (!EnemyClass || GetWorld()->GetNetMode() == NM_Client) return nullptr;
+
+	FEnemyPool& Pool = Pools.FindOrAdd(EnemyClass);
+
+	// Dormant enemies may have been destroyed externally (level streaming, GM commands)
+
+	while (Pool.Available.Num() > 0)
+	{
+		AZoneProjectCharacter* Enemy = Pool.Available.Pop(EAllowShrinking::No);
+		if (!IsValid(Enemy)) continue;
+
+		Pool.Hits++;
+		Enemy->ExitDormancy(Transform);
+
+		return Enemy;
+	}
+
+	Pool.Misses++;
+
+	return SpawnEnemy(EnemyClass, Transform);
+}
+
+void UZoneProjectEnemyPoolSubsystem::ReleaseEnemy(AZoneProjectCharacter* Enemy)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectReleaseEnemy);
+
+	if (!IsValid(Enemy) || Enemy->IsDormant()) return;
+
+	FEnemyPool& Pool = Pools.FindOrAdd(Enemy->GetClass());
+
+	if (Pool.Available.Num() >= MaxDormantEnemies)
+	{
+		Enemy->Destroy();
+		return;
+	}
+
+	Enemy->EnterDormancy();
+	Pool.Available.Add(Enemy);
+}
+
+void UZoneProjectEnemyPoolSubsystem::DumpStats() const
+{
+	const UWorld* World = GetWorld();
+	const FString MapName = World ? World->GetMapName() : FString();
+
+	for (const TPair<TSubclassOf<AZoneProjectCharacter>, FEnemyPool>& Pair : Pools)
+	{
+		const FEnemyPool& Pool = Pair.Value;
+
+		UE_LOG(LogZoneProject, Log, TEXT("Enemy pool [%s] on %s: Hits: %d; Misses: %d; Dormant: %d"),
+			*GetNameSafe(Pair.Key), *MapName, Pool.Hits, Pool.Misses, Pool.Available.Num());
+	}
+}
@@ -1,50 +1,149 @@
 // Copyright Anton Romanov. All Rights Reserved.
 
 #include "ZoneProjectGameMode.h"
+#include "ZoneProject/ZoneProject.h"
 #include "ZoneProjectCharacter.h"
-#include "Kismet/GameplayStatics.h"
+#include "ZoneProjectEnemyPoolSubsystem.h"
+#include "ZoneProjectGameContent.h"
+#include "ZoneProjectWaveDirectorSubsystem.h"
+#include "Engine/AssetManager.h"
 
 AZoneProjectGameMode::AZoneProjectGameMode()
 {
 }
 
+void AZoneProjectGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	PreloadGameContent();
+}
+
 void AZoneProjectGameMode::BeginPlay()
 {
 	Super::BeginPlay();
 
-	FTimerManager& TimerManager = GetWorldTimerManager();
-	TimerManager.SetTimer(RemoveTimer, this, &AZoneProjectGameMode::SpawnEnemy, EnemySpawnRate, true);
+	if (bGameContentReady) StartWaves();
 }
 
-void AZoneProjectGameMode::SpawnEnemy()
+void AZoneProjectGameMode::PreloadGameContent()
 {
-	if (DefaultEnemyClass)
+	UAssetManager& AssetManager = UAssetManager::Get();
+
+	TArray<TSharedPtr<FStreamableHandle>> Handles;
+
+	// The game content asset lists the classes of the match in its bundle
+
+	const FPrimaryAssetId ContentId = AssetManager.GetPrimaryAssetIdForPath(GameContent.ToSoftObjectPath());
+
+	if (ContentId.IsValid())
 	{
-		if (const APlayerController* Player = UGameplayStatics::GetPlayerController(this, 0))
-		{
-			if (const APawn* PlayerPawn = Player->GetPawn())
-			{
-				// Calculate the enemy spawn position
-				
-				FVector Origin = PlayerPawn->GetActorLocation();
+		Handles.Add(AssetManager.LoadPrimaryAsset(ContentId, { PreloadBundle }));
+	}
+	else if (!GameContent.IsNull())
+	{
+		UE_LOG(LogZoneProject, Warning, TEXT("%s is not a registered primary asset, its %s bundle is not preloaded"), *GameContent.ToString(), *PreloadBundle.ToString());
+	}
+
+	// The enemy and pawn classes are loaded in any case, so the match can start without a game content asset
+
+	TArray<FSoftObjectPath> Paths;
 
-				const float Angle = FMath::RandRange(-180.f, 180.f);
+	if (!DefaultEnemyClass.IsNull()) Paths.Add(DefaultEnemyClass.ToSoftObjectPath());
+	if (DefaultPawnClass) Paths.AddUnique(FSoftObjectPath(DefaultPawnClass.Get()));
 
-				const float X = EnemySpawnDistance * FMath::Cos(Angle);
-				const float Y = EnemySpawnDistance * FMath::Sin(Angle);
+	if (Paths.Num() > 0) Handles.Add(AssetManager.GetStreamableManager().RequestAsyncLoad(Paths));
 
-				Origin.X += X;
-				Origin.Y += Y;
+	WaitForPreload(Handles, FStreamableDelegate::CreateUObject(this, &AZoneProjectGameMode::OnGameClassesLoaded));
+}
 
-				// Spawn the enemy
+void AZoneProjectGameMode::OnGameClassesLoaded()
+{
+	// Weapons and drop items missing from the bundle are found in the defaults of the loaded characters
 
-				const FTransform SpawnTransform(Origin);
+	TArray<FSoftObjectPath> Paths;
 
-				FActorSpawnParameters SpawnInfo;
-				SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
-				
-				GetWorld()->SpawnActor<AZoneProjectCharacter>(DefaultEnemyClass, SpawnTransform, SpawnInfo);
-			}
+	for (const UClass* Class : { DefaultEnemyClass.Get(), DefaultPawnClass.Get() })
+	{
+		if (const AZoneProjectCharacter* Defaults = Class ? Cast<AZoneProjectCharacter>(Class->GetDefaultObject()) : nullptr)
+		{
+			Defaults->GetContentPaths(Paths);
 		}
 	}
+
+	Paths.RemoveAll([](const FSoftObjectPath& Path) { return Path.ResolveObject() != nullptr; });
+
+	TArray<TSharedPtr<FStreamableHandle>> Handles;
+
+	if (Paths.Num() > 0)
+	{
+		UE_LOG(LogZoneProject, Warning, TEXT("%d classes spawned by the characters are missing from the %s bundle of the game content"), Paths.Num(), *PreloadBundle.ToString());
+		Handles.Add(UAssetManager::GetStreamableManager().RequestAsyncLoad(Paths));
+	}
+
+	WaitForPreload(Handles, FStreamableDelegate::CreateUObject(this, &AZoneProjectGameMode::OnGameContentLoaded));
+}
+
+void AZoneProjectGameMode::WaitForPreload(TArray<TSharedPtr<FStreamableHandle>> Handles, const FStreamableDelegate& Callback)
+{
+	Handles.RemoveAll([](const TSharedPtr<FStreamableHandle>& Handle) { return !Handle.IsValid(); });
+
+	if (Handles.IsEmpty())
+	{
+		Callback.ExecuteIfBound();
+		return;
+	}
+
+	PreloadHandles.Append(Handles);
+
+	const TSharedPtr<FStreamableHandle> Handle = Handles.Num() == 1 ? Handles[0] : UAssetManager::GetStreamableManager().CreateCombinedHandle(Handles);
+
+	if (!Handle.IsValid() || Handle->HasLoadCompleted())
+	{
+		Callback.ExecuteIfBound();
+	}
+	else
+	{
+		Handle->BindCompleteDelegate(Callback);
+	}
+}
+
+void AZoneProjectGameMode::OnGameContentLoaded()
+{
+	if (bGameContentReady) return;
+
+	bGameContentReady = true;
+
+	UE_LOG(LogZoneProject, Log, TEXT("Game content of the %s bundle loaded"), *PreloadBundle.ToString());
+
+	if (HasActorBegunPlay()) StartWaves();
+}
+
+void AZoneProjectGameMode::StartWaves()
+{
+	// Spawn the dormant enemies up front so waves don't hitch on spawning characters
+
+	if (UZoneProjectEnemyPoolSubsystem* EnemyPool = GetWorld()->GetSubsystem<UZoneProjectEnemyPoolSubsystem>())
+	{
+		EnemyPool->WarmUp(DefaultEnemyClass.Get(), EnemyPoolSize);
+	}
+
+	FTimerManager& TimerManager = GetWorldTimerManager();
+	TimerManager.SetTimer(WaveTimer, this, &AZoneProjectGameMode::StartWave, EnemySpawnRate, true);
+}
+
+void AZoneProjectGameMode::StartWave()
+{
+	UZoneProjectWaveDirectorSubsystem* WaveDirector = GetWorld()->GetSubsystem<UZoneProjectWaveDirectorSubsystem>();
+	const TSubclassOf<AZoneProjectCharacter> EnemyClass = DefaultEnemyClass.Get();
+
+	if (!WaveDirector || !EnemyClass || !bGameContentReady) return;
+
+	// Waves grow with every wave up to the limit, the director spreads them across the players and frames
+
+	const int32 EnemiesPerPlayer = FMath::Min(WaveEnemiesPerPlayer + FMath::FloorToInt32(WaveNumber * WaveEnemiesPerPlayerGrowth), MaxWaveEnemiesPerPlayer);
+
+	WaveDirector->QueueWave(EnemyClass, EnemiesPerPlayer, EnemySpawnDistance, EnemySpawnClearance);
+
+	++WaveNumber;
 }
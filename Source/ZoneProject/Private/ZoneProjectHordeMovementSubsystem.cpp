@@ -0,0 +1,314 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#include "ZoneProjectHordeMovementSubsystem.h"
+#include "ZoneProject/ZoneProject.h"
+#include "ZoneProjectCharacter.h"
+#include "ZoneProjectCharacterMovement.h"
+#include "AIController.h"
+#include "Async/ParallelFor.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "NavigationData.h"
+#include "NavigationSystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Gather Horde"), STAT_ZoneProjectGatherHorde, STATGROUP_ZoneProject);
+DECLARE_CYCLE_STAT(TEXT("Simulate Horde"), STAT_ZoneProjectSimulateHorde, STATGROUP_ZoneProject);
+DECLARE_CYCLE_STAT(TEXT("Apply Horde"), STAT_ZoneProjectApplyHorde, STATGROUP_ZoneProject);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Horde Members"), STAT_ZoneProjectHordeMembers, STATGROUP_ZoneProject);
+
+static TAutoConsoleVariable<bool> CVarHordeMovement(
+	TEXT("ZoneProject.Horde.Enabled"),
+	true,
+	TEXT("Move AI enemies far from players with the batched horde movement"));
+
+static TAutoConsoleVariable<bool> CVarParallelHorde(
+	TEXT("ZoneProject.Horde.Parallel"),
+	true,
+	TEXT("Simulate the horde movement on worker threads"));
+
+void UZoneProjectHordeMovementSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Characters.Num() == 0 || GetWorld()->GetNetMode() == NM_Client) return;
+
+	GatherMembers();
+
+	SET_DWORD_STAT(STAT_ZoneProjectHordeMembers, Members.Num());
+
+	if (Members.Num() == 0) return;
+
+	BuildGrid();
+	SimulateMembers(DeltaTime);
+	ApplyMembers();
+}
+
+TStatId UZoneProjectHordeMovementSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UZoneProjectHordeMovementSubsystem, STATGROUP_ZoneProject);
+}
+
+bool UZoneProjectHordeMovementSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UZoneProjectHordeMovementSubsystem::RegisterCharacter(AZoneProjectCharacter* Character)
+{
+	if (Character) Characters.AddUnique(Character);
+}
+
+void UZoneProjectHordeMovementSubsystem::UnregisterCharacter(AZoneProjectCharacter* Character)
+{
+	if (!Character) return;
+
+	Characters.RemoveSwap(Character, EAllowShrinking::No);
+
+	UZoneProjectCharacterMovement* Movement = Cast<UZoneProjectCharacterMovement>(Character->GetCharacterMovement());
+	if (Movement && Movement->IsHordeMoving()) Movement->SetMovementMode(MOVE_Walking);
+}
+
+bool UZoneProjectHordeMovementSubsystem::CanUseHordeMovement(const AZoneProjectCharacter* Character, const bool bIsHordeMoving) const
+{
+	if (!CVarHordeMovement.GetValueOnGameThread()) return false;
+
+	if (!Character->IsAlive() || Character->IsDormant() || Character->IsPlayerControlled()) return false;
+	if (!Cast<AAIController>(Character->GetController())) return false;
+
+	// Knocked into physics or off the ground, the full movement has to resolve it
+
+	if (Character->GetMesh()->IsSimulatingPhysics()) return false;
+	if (!bIsHordeMoving && !Character->GetCharacterMovement()->IsMovingOnGround()) return false;
+
+	const float Distance = FullMovementDistance + (bIsHordeMoving ? 0.f : HysteresisDistance);
+	const FVector Location = Character->GetActorLocation();
+
+	for (const FVector& PlayerLocation : PlayerLocations)
+	{
+		if (FVector::DistSquared2D(Location, PlayerLocation) < FMath::Square(Distance)) return false;
+	}
+
+	return true;
+}
+
+void UZoneProjectHordeMovementSubsystem::GatherMembers()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectGatherHorde);
+
+	PlayerLocations.Reset();
+
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController* PlayerController = Iterator->Get();
+		const APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+
+		if (Pawn) PlayerLocations.Add(Pawn->GetActorLocation());
+	}
+
+	Members.Reset();
+	Positions.Reset();
+	Velocities.Reset();
+	DesiredVelocities.Reset();
+	Yaws.Reset();
+	MaxSpeeds.Reset();
+	MaxAccelerations.Reset();
+	TurnRates.Reset();
+	HalfHeights.Reset();
+
+	// Iterate backwards so swap-removal doesn't skip elements
+
+	for (int32 Index = Characters.Num() - 1; Index >= 0; --Index)
+	{
+		AZoneProjectCharacter* Character = Characters[Index].Get();
+
+		if (!Character)
+		{
+			Characters.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+			continue;
+		}
+
+		UZoneProjectCharacterMovement* Movement = Cast<UZoneProjectCharacterMovement>(Character->GetCharacterMovement());
+		if (!Movement) continue;
+
+		const bool bIsHordeMoving = Movement->IsHordeMoving();
+		const bool bCanUseHordeMovement = CanUseHordeMovement(Character, bIsHordeMoving);
+
+		if (bIsHordeMoving != bCanUseHordeMovement)
+		{
+			if (bCanUseHordeMovement) Movement->SetMovementMode(MOVE_Custom, CMOVE_Horde); else Movement->SetMovementMode(MOVE_Walking);
+		}
+
+		if (!bCanUseHordeMovement) continue;
+
+		Members.Add(Character);
+		Positions.Add(Character->GetActorLocation());
+		Velocities.Add(FVector(Movement->Velocity.X, Movement->Velocity.Y, 0.f));
+		DesiredVelocities.Add(Movement->ConsumeHordeDesiredVelocity() * FVector(1.f, 1.f, 0.f));
+		Yaws.Add(Character->GetActorRotation().Yaw);
+		MaxSpeeds.Add(Movement->GetMaxSpeed());
+		MaxAccelerations.Add(Movement->GetMaxAcceleration());
+		TurnRates.Add(Movement->RotationRate.Yaw);
+		HalfHeights.Add(Character->GetCapsuleComponent()->GetScaledCapsuleHalfHeight());
+	}
+}
+
+uint64 UZoneProjectHordeMovementSubsystem::GetCellKey(const FVector& Location) const
+{
+	const int32 X = FMath::FloorToInt32(Location.X / SeparationRadius);
+	const int32 Y = FMath::FloorToInt32(Location.Y / SeparationRadius);
+
+	return (static_cast<uint64>(static_cast<uint32>(X)) << 32) | static_cast<uint32>(Y);
+}
+
+void UZoneProjectHordeMovementSubsystem::BuildGrid()
+{
+	const int32 Num = Members.Num();
+
+	CellKeys.SetNumUninitialized(Num, EAllowShrinking::No);
+	SortedMembers.SetNumUninitialized(Num, EAllowShrinking::No);
+
+	for (int32 Index = 0; Index < Num; ++Index)
+	{
+		CellKeys[Index] = GetCellKey(Positions[Index]);
+		SortedMembers[Index] = Index;
+	}
+
+	// Members of the same cell are stored contiguously, the map only points at the first one
+
+	SortedMembers.Sort([this](const int32 A, const int32 B) { return CellKeys[A] < CellKeys[B]; });
+
+	CellStarts.Reset();
+
+	for (int32 Index = 0; Index < Num; ++Index)
+	{
+		const uint64 Key = CellKeys[SortedMembers[Index]];
+		if (Index == 0 || Key != CellKeys[SortedMembers[Index - 1]]) CellStarts.Add(Key, Index);
+	}
+}
+
+void UZoneProjectHordeMovementSubsystem::SimulateMembers(const float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectSimulateHorde);
+
+	const int32 Num = Members.Num();
+
+	NewPositions.SetNumUninitialized(Num, EAllowShrinking::No);
+
+	// Every member only writes its own state and reads the positions of the others, which don't change until the apply step
+
+	const EParallelForFlags Flags = CVarParallelHorde.GetValueOnGameThread() ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread;
+
+	ParallelFor(TEXT("ZoneProjectHorde"), Num, ParallelBatchSize, [this, DeltaTime](const int32 Index)
+	{
+		const FVector Position = Positions[Index];
+		FVector Velocity = Velocities[Index];
+
+		// Accelerate towards the path following velocity
+
+		const FVector VelocityDelta = DesiredVelocities[Index] - Velocity;
+		Velocity += VelocityDelta.GetClampedToMaxSize(MaxAccelerations[Index] * DeltaTime);
+
+		// Push away from the neighbors in the surrounding cells
+
+		FVector Push = FVector::ZeroVector;
+
+		const int32 CellX = FMath::FloorToInt32(Position.X / SeparationRadius);
+		const int32 CellY = FMath::FloorToInt32(Position.Y / SeparationRadius);
+
+		for (int32 OffsetX = -1; OffsetX <= 1; ++OffsetX)
+		{
+			for (int32 OffsetY = -1; OffsetY <= 1; ++OffsetY)
+			{
+				const uint64 Key = (static_cast<uint64>(static_cast<uint32>(CellX + OffsetX)) << 32) | static_cast<uint32>(CellY + OffsetY);
+
+				const int32* Start = CellStarts.Find(Key);
+				if (!Start) continue;
+
+				for (int32 Sorted = *Start; Sorted < SortedMembers.Num() && CellKeys[SortedMembers[Sorted]] == Key; ++Sorted)
+				{
+					const int32 Other = SortedMembers[Sorted];
+					if (Other == Index) continue;
+
+					const FVector Offset = (Position - Positions[Other]) * FVector(1.f, 1.f, 0.f);
+					const float DistanceSquared = Offset.SizeSquared();
+
+					if (DistanceSquared < FMath::Square(SeparationRadius) && DistanceSquared > UE_KINDA_SMALL_NUMBER)
+					{
+						const float Distance = FMath::Sqrt(DistanceSquared);
+						Push += Offset / Distance * (1.f - Distance / SeparationRadius);
+					}
+				}
+			}
+		}
+
+		Velocity += Push * SeparationStrength * MaxAccelerations[Index] * DeltaTime;
+		Velocity = Velocity.GetClampedToMaxSize2D(MaxSpeeds[Index]);
+		Velocity.Z = 0.f;
+
+		// Face the movement direction
+
+		if (Velocity.SizeSquared2D() > UE_KINDA_SMALL_NUMBER)
+		{
+			Yaws[Index] = FMath::FixedTurn(Yaws[Index], Velocity.Rotation().Yaw, TurnRates[Index] * DeltaTime);
+		}
+
+		Velocities[Index] = Velocity;
+
+		NewPositions[Index] = Position + Velocity * DeltaTime;
+	}, Flags);
+}
+
+void UZoneProjectHordeMovementSubsystem::ApplyMembers()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectApplyHorde);
+
+	const UNavigationSystemV1* NavigationSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const ANavigationData* NavigationData = NavigationSystem ? NavigationSystem->GetDefaultNavDataInstance() : nullptr;
+
+	// Without a navmesh keep the height, otherwise snap the feet to the navmesh in one batched query
+
+	ProjectionWork.Reset();
+
+	for (int32 Index = 0; Index < Members.Num(); ++Index)
+	{
+		ProjectionWork.Emplace(NewPositions[Index] - FVector(0.f, 0.f, HalfHeights[Index]));
+	}
+
+	if (NavigationData)
+	{
+		NavigationData->BatchProjectPoints(ProjectionWork, ProjectionExtent);
+	}
+
+	for (int32 Index = 0; Index < Members.Num(); ++Index)
+	{
+		AZoneProjectCharacter* Character = Members[Index];
+		UCharacterMovementComponent* Movement = Character->GetCharacterMovement();
+
+		const FNavigationProjectionWork& Work = ProjectionWork[Index];
+
+		FVector Location;
+
+		if (!NavigationData)
+		{
+			Location = Work.Point + FVector(0.f, 0.f, HalfHeights[Index]);
+		}
+		else if (Work.bResult)
+		{
+			Location = Work.OutLocation.Location + FVector(0.f, 0.f, HalfHeights[Index]);
+		}
+		else
+		{
+			// Stop at the navmesh edge
+
+			Location = Positions[Index];
+			Velocities[Index] = FVector::ZeroVector;
+		}
+
+		Character->SetActorLocationAndRotation(Location, FRotator(0.f, Yaws[Index], 0.f), false, nullptr, ETeleportType::None);
+
+		// Keep the velocity visible to animation and movement replication
+
+		Movement->Velocity = Velocities[Index];
+		Movement->UpdateComponentVelocity();
+	}
+}
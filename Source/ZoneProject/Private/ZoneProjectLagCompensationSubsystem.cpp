@@ -0,0 +1,176 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#include "ZoneProjectLagCompensationSubsystem.h"
+#include "ZoneProject/ZoneProject.h"
+#include "ZoneProjectCharacter.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Record Hitboxes"), STAT_ZoneProjectRecordHitboxes, STATGROUP_ZoneProject);
+DECLARE_CYCLE_STAT(TEXT("Validate Hit"), STAT_ZoneProjectValidateHit, STATGROUP_ZoneProject);
+
+void UZoneProjectLagCompensationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const UWorld* World = GetWorld();
+	if (World->GetNetMode() == NM_Client) return;
+
+	// Record at a fixed rate so the memory needed for the rewind window doesn't depend on the frame rate
+
+	const double Time = World->GetTimeSeconds();
+
+	if (Time - LastRecordTime >= 1.0 / RecordRate)
+	{
+		LastRecordTime = Time;
+		RecordFrames(Time);
+	}
+}
+
+TStatId UZoneProjectLagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UZoneProjectLagCompensationSubsystem, STATGROUP_ZoneProject);
+}
+
+bool UZoneProjectLagCompensationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UZoneProjectLagCompensationSubsystem::RecordFrames(const double Time)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectRecordHitboxes);
+
+	for (FZoneProjectHitboxHistory& History : Histories)
+	{
+		const AZoneProjectCharacter* Character = History.Character.Get();
+		if (!Character) continue;
+
+		const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+
+		FZoneProjectHitboxFrame& Frame = History.Frames[History.Head];
+
+		Frame.Time = Time;
+		Frame.Location = Capsule->GetComponentLocation();
+		Frame.Rotation = Capsule->GetComponentQuat();
+		Frame.Radius = Capsule->GetScaledCapsuleRadius();
+		Frame.HalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+
+		History.Head = (History.Head + 1) % History.Frames.Num();
+		History.Num = FMath::Min(History.Num + 1, History.Frames.Num());
+	}
+}
+
+void UZoneProjectLagCompensationSubsystem::RegisterCharacter(AZoneProjectCharacter* Character)
+{
+	if (!Character || HistoryIndices.Contains(Character)) return;
+
+	// Allocate the whole rewind window once, plus one frame to interpolate at its oldest edge
+
+	const int32 Capacity = FMath::CeilToInt(MaxRewindTime * RecordRate) + 2;
+
+	FZoneProjectHitboxHistory& History = Histories.AddDefaulted_GetRef();
+	History.Character = Character;
+	History.Key = Character;
+	History.Frames.SetNum(Capacity);
+
+	HistoryIndices.Add(Character, Histories.Num() - 1);
+}
+
+void UZoneProjectLagCompensationSubsystem::UnregisterCharacter(AZoneProjectCharacter* Character)
+{
+	int32 Index;
+	if (!HistoryIndices.RemoveAndCopyValue(Character, Index)) return;
+
+	Histories.RemoveAtSwap(Index);
+
+	// Fix up the index of the history moved into the freed slot
+
+	if (Histories.IsValidIndex(Index))
+	{
+		HistoryIndices.Add(Histories[Index].Key, Index);
+	}
+}
+
+bool UZoneProjectLagCompensationSubsystem::GetHitboxAtTime(const AZoneProjectCharacter* Character, const double Time,
+	FZoneProjectHitboxFrame& OutFrame) const
+{
+	const int32* Index = HistoryIndices.Find(Character);
+	if (!Index) return false;
+
+	const FZoneProjectHitboxHistory& History = Histories[*Index];
+	if (History.Num == 0) return false;
+
+	// Newer than the latest frame, use the latest one
+
+	const FZoneProjectHitboxFrame& Latest = History.GetFrame(0);
+
+	if (Time >= Latest.Time)
+	{
+		OutFrame = Latest;
+		return true;
+	}
+
+	// Walk back from the newest frame until the requested time is bracketed
+
+	for (int32 Age = 1; Age < History.Num; ++Age)
+	{
+		const FZoneProjectHitboxFrame& Older = History.GetFrame(Age);
+		if (Older.Time > Time) continue;
+
+		const FZoneProjectHitboxFrame& Newer = History.GetFrame(Age - 1);
+		const float Alpha = static_cast<float>((Time - Older.Time) / FMath::Max(Newer.Time - Older.Time, UE_DOUBLE_SMALL_NUMBER));
+
+		OutFrame.Time = Time;
+		OutFrame.Location = FMath::Lerp(Older.Location, Newer.Location, Alpha);
+		OutFrame.Rotation = FQuat::Slerp(Older.Rotation, Newer.Rotation, Alpha);
+		OutFrame.Radius = FMath::Lerp(Older.Radius, Newer.Radius, Alpha);
+		OutFrame.HalfHeight = FMath::Lerp(Older.HalfHeight, Newer.HalfHeight, Alpha);
+
+		return true;
+	}
+
+	// Older than the rewind window
+	return false;
+}
+
+bool UZoneProjectLagCompensationSubsystem::ValidateHit(const AZoneProjectCharacter* Shooter, const AZoneProjectCharacter* Character,
+	const double Time, const FVector& Origin, const FVector& Direction, const float MaxDistance) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectValidateHit);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	if (Time < Now - MaxRewindTime || Time > Now + MaxFutureTime)
+	{
+		UE_LOG(LogZoneProject, Verbose, TEXT("Hit on %s rejected: timestamp %f is outside the rewind window (now %f)"), *GetNameSafe(Character), Time, Now);
+		return false;
+	}
+
+	// The client shoots from its predicted location, which the server reaches somewhere between the reported time and now
+
+	if (!Shooter) return false;
+
+	FZoneProjectHitboxFrame ShooterFrame;
+	const FVector ShooterLocation = Shooter->GetActorLocation();
+	const FVector RewoundLocation = GetHitboxAtTime(Shooter, Time, ShooterFrame) ? ShooterFrame.Location : ShooterLocation;
+
+	if (FMath::PointDistToSegmentSquared(Origin, RewoundLocation, ShooterLocation) > FMath::Square(MaxOriginDistance))
+	{
+		UE_LOG(LogZoneProject, Verbose, TEXT("Hit on %s rejected: origin %s is too far from %s"), *GetNameSafe(Character), *Origin.ToString(), *GetNameSafe(Shooter));
+		return false;
+	}
+
+	FZoneProjectHitboxFrame Frame;
+	if (!GetHitboxAtTime(Character, Time, Frame)) return false;
+
+	// Closest distance between the shot segment and the capsule axis
+
+	const FVector Axis = Frame.Rotation.GetUpVector() * FMath::Max(Frame.HalfHeight - Frame.Radius, 0.f);
+	const FVector ShotEnd = Origin + Direction.GetSafeNormal() * MaxDistance;
+
+	FVector ShotPoint, AxisPoint;
+	FMath::SegmentDistToSegmentSafe(Origin, ShotEnd, Frame.Location - Axis, Frame.Location + Axis, ShotPoint, AxisPoint);
+
+	return FVector::DistSquared(ShotPoint, AxisPoint) <= FMath::Square(Frame.Radius + HitTolerance);
+}
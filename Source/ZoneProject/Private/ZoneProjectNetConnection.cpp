@@ -0,0 +1,28 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#include "ZoneProjectNetConnection.h"
+#include "Engine/ActorChannel.h"
+#include "Net/DataBunch.h"
+
+int32 UZoneProjectNetConnection::SendRawBunch(FOutBunch& Bunch, bool InAllowMerge, const FNetTraceCollector* BunchCollector)
+{
+	// Partial bunches of a large update are counted one by one, so the total matches what goes on the wire
+
+	if (const UActorChannel* ActorChannel = Cast<UActorChannel>(Bunch.Channel))
+	{
+		const AActor* Actor = ActorChannel->GetActor();
+		OutBitsByClass.FindOrAdd(Actor ? Actor->GetClass()->GetFName() : NAME_Actor) += Bunch.GetNumBits();
+	}
+	else if (Bunch.Channel)
+	{
+		OutBitsByClass.FindOrAdd(Bunch.Channel->ChName) += Bunch.GetNumBits();
+	}
+
+	return Super::SendRawBunch(Bunch, InAllowMerge, BunchCollector);
+}
+
+void UZoneProjectNetConnection::ConsumeOutBitsByClass(TMap<FName, int64>& OutBits)
+{
+	OutBits = MoveTemp(OutBitsByClass);
+	OutBitsByClass.Reset();
+}
@@ -0,0 +1,279 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#include "ZoneProjectNetTelemetrySubsystem.h"
+#include "ZoneProject/ZoneProject.h"
+#include "ZoneProjectCharacterMovement.h"
+#include "ZoneProjectNetConnection.h"
+#include "Engine/Channel.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DECLARE_CYCLE_STAT(TEXT("Sample Net Telemetry"), STAT_ZoneProjectSampleNetTelemetry, STATGROUP_ZoneProjectNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Client Connections"), STAT_ZoneProjectNetConnections, STATGROUP_ZoneProjectNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("In Bytes Per Second"), STAT_ZoneProjectNetInBytes, STATGROUP_ZoneProjectNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Out Bytes Per Second"), STAT_ZoneProjectNetOutBytes, STATGROUP_ZoneProjectNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Max Reliable Buffer"), STAT_ZoneProjectNetReliableBuffer, STATGROUP_ZoneProjectNet);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Max Round Trip (ms)"), STAT_ZoneProjectNetMaxRoundTrip, STATGROUP_ZoneProjectNet);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Max Jitter (ms)"), STAT_ZoneProjectNetMaxJitter, STATGROUP_ZoneProjectNet);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Max Packet Loss (%)"), STAT_ZoneProjectNetMaxLoss, STATGROUP_ZoneProjectNet);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Corrections Per Second"), STAT_ZoneProjectNetCorrections, STATGROUP_ZoneProjectNet);
+
+static FAutoConsoleCommandWithWorld GNetTelemetryCommand(
+	TEXT("ZoneProject.Net.Telemetry"),
+	TEXT("Print the latest net telemetry sample of every client connection in the current world"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UZoneProjectNetTelemetrySubsystem* Subsystem = World ? World->GetSubsystem<UZoneProjectNetTelemetrySubsystem>() : nullptr)
+		{
+			Subsystem->DumpStats();
+		}
+	}));
+
+/* Number of classes printed per connection by the console command */
+static constexpr int32 MaxDumpedClasses = 5;
+
+void UZoneProjectNetTelemetrySubsystem::Deinitialize()
+{
+	FlushCsv();
+
+	Super::Deinitialize();
+}
+
+void UZoneProjectNetTelemetrySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!bEnabled || GetWorld()->GetNetMode() == NM_Client || GetWorld()->GetNetMode() == NM_Standalone) return;
+
+	// Engine connection stats are only refreshed every net stat period, sampling them every frame would repeat the same values
+
+	SampleElapsed += DeltaTime;
+
+	if (SampleElapsed >= SampleInterval)
+	{
+		Sample(SampleElapsed);
+		SampleElapsed = 0.f;
+	}
+
+	CsvElapsed += DeltaTime;
+
+	if (CsvElapsed >= CsvInterval)
+	{
+		FlushCsv();
+		CsvElapsed = 0.f;
+	}
+}
+
+TStatId UZoneProjectNetTelemetrySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UZoneProjectNetTelemetrySubsystem, STATGROUP_ZoneProjectNet);
+}
+
+bool UZoneProjectNetTelemetrySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UZoneProjectNetTelemetrySubsystem::Sample(const float Elapsed)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectSampleNetTelemetry);
+
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	if (!NetDriver) return;
+
+	const double Time = GetWorld()->GetTimeSeconds();
+
+	int32 TotalInBytes = 0;
+	int32 TotalOutBytes = 0;
+	int32 MaxReliableBuffer = 0;
+	float MaxRoundTrip = 0.f;
+	float MaxJitter = 0.f;
+	float MaxLoss = 0.f;
+	float TotalCorrections = 0.f;
+
+	// Closed connections are dropped, their last rows are already in the CSV
+
+	for (auto It = Connections.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().ResolveObjectPtr()) It.RemoveCurrent();
+	}
+
+	for (UNetConnection* Connection : NetDriver->ClientConnections)
+	{
+		if (!Connection || Connection->GetConnectionState() != USOCK_Open) continue;
+
+		FZoneProjectConnectionTelemetry& Telemetry = Connections.FindOrAdd(Connection);
+
+		// Keep at least one sample, the stats read the latest round trip
+
+		const int32 HistorySize = FMath::Max(RoundTripHistorySize, 1);
+		if (Telemetry.RoundTrip.GetCapacity() != HistorySize) Telemetry.RoundTrip.Init(HistorySize);
+
+		const APlayerController* PlayerController = Connection->PlayerController;
+		const APlayerState* PlayerState = PlayerController ? PlayerController->PlayerState.Get() : nullptr;
+
+		Telemetry.Name = FString::Printf(TEXT("%s %s"), PlayerState ? *PlayerState->GetPlayerName() : TEXT("(connecting)"),
+			*Connection->LowLevelGetRemoteAddress(true)).Replace(TEXT(","), TEXT(" "));
+
+		// Jitter is the deviation of the round trip over the history
+
+		Telemetry.RoundTrip.Add(Connection->AvgLag * 1000.f);
+
+		Telemetry.InLoss = Connection->GetInLossPercentage().GetAvgLossPercentage() * 100.f;
+		Telemetry.OutLoss = Connection->GetOutLossPercentage().GetAvgLossPercentage() * 100.f;
+
+		Telemetry.InBytesPerSecond = Connection->InBytesPerSecond;
+		Telemetry.OutBytesPerSecond = Connection->OutBytesPerSecond;
+
+		Telemetry.ReliableBufferMax = 0;
+		Telemetry.ReliableBufferTotal = 0;
+
+		for (const UChannel* Channel : Connection->OpenChannels)
+		{
+			if (!Channel) continue;
+
+			Telemetry.ReliableBufferMax = FMath::Max(Telemetry.ReliableBufferMax, Channel->NumOutRec);
+			Telemetry.ReliableBufferTotal += Channel->NumOutRec;
+		}
+
+		int32 Moves = 0;
+		int32 Corrections = 0;
+
+		if (const ACharacter* Character = PlayerController ? Cast<ACharacter>(PlayerController->GetPawn()) : nullptr)
+		{
+			if (UZoneProjectCharacterMovement* CharacterMovement = Cast<UZoneProjectCharacterMovement>(Character->GetCharacterMovement()))
+			{
+				CharacterMovement->ConsumeNetStats(Moves, Corrections);
+			}
+		}
+
+		Telemetry.MovesPerSecond = Moves / Elapsed;
+		Telemetry.CorrectionsPerSecond = Corrections / Elapsed;
+
+		Telemetry.OutBytesByClass.Reset();
+
+		if (UZoneProjectNetConnection* ConnectionCasted = Cast<UZoneProjectNetConnection>(Connection))
+		{
+			TMap<FName, int64> OutBits;
+			ConnectionCasted->ConsumeOutBitsByClass(OutBits);
+
+			for (const TPair<FName, int64>& Pair : OutBits) Telemetry.OutBytesByClass.Add(Pair.Key, Pair.Value / 8.f / Elapsed);
+		}
+
+		Telemetry.RpcRates.Reset();
+
+		for (const TPair<FName, int32>& Pair : Telemetry.PendingRpcCounts) Telemetry.RpcRates.Add(Pair.Key, Pair.Value / Elapsed);
+		Telemetry.PendingRpcCounts.Reset();
+
+		TotalInBytes += Telemetry.InBytesPerSecond;
+		TotalOutBytes += Telemetry.OutBytesPerSecond;
+		MaxReliableBuffer = FMath::Max(MaxReliableBuffer, Telemetry.ReliableBufferMax);
+		MaxRoundTrip = FMath::Max(MaxRoundTrip, Telemetry.RoundTrip.Last());
+		MaxJitter = FMath::Max(MaxJitter, static_cast<float>(Telemetry.RoundTrip.GetStandardDeviation()));
+		MaxLoss = FMath::Max(MaxLoss, FMath::Max(Telemetry.InLoss, Telemetry.OutLoss));
+		TotalCorrections += Telemetry.CorrectionsPerSecond;
+
+		if (!bWriteCsv) continue;
+
+		FString Rpcs;
+		for (const TPair<FName, float>& Pair : Telemetry.RpcRates) Rpcs += FString::Printf(TEXT("%s%s=%.1f"), Rpcs.IsEmpty() ? TEXT("") : TEXT(";"), *Pair.Key.ToString(), Pair.Value);
+
+		PendingConnectionRows += FString::Printf(TEXT("%.2f,%s,%.1f,%.1f,%.1f,%.2f,%.2f,%d,%d,%d,%d,%.1f,%.2f,%s\n"),
+			Time, *Telemetry.Name, Telemetry.RoundTrip.Last(), Telemetry.RoundTrip.GetPercentile(0.95), Telemetry.RoundTrip.GetStandardDeviation(),
+			Telemetry.InLoss, Telemetry.OutLoss, Telemetry.InBytesPerSecond, Telemetry.OutBytesPerSecond, Telemetry.ReliableBufferMax,
+			Telemetry.ReliableBufferTotal, Telemetry.MovesPerSecond, Telemetry.CorrectionsPerSecond, *Rpcs);
+
+		for (const TPair<FName, float>& Pair : Telemetry.OutBytesByClass)
+		{
+			PendingClassRows += FString::Printf(TEXT("%.2f,%s,%s,%.0f\n"), Time, *Telemetry.Name, *Pair.Key.ToString(), Pair.Value);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_ZoneProjectNetConnections, Connections.Num());
+	SET_DWORD_STAT(STAT_ZoneProjectNetInBytes, TotalInBytes);
+	SET_DWORD_STAT(STAT_ZoneProjectNetOutBytes, TotalOutBytes);
+	SET_DWORD_STAT(STAT_ZoneProjectNetReliableBuffer, MaxReliableBuffer);
+	SET_FLOAT_STAT(STAT_ZoneProjectNetMaxRoundTrip, MaxRoundTrip);
+	SET_FLOAT_STAT(STAT_ZoneProjectNetMaxJitter, MaxJitter);
+	SET_FLOAT_STAT(STAT_ZoneProjectNetMaxLoss, MaxLoss);
+	SET_FLOAT_STAT(STAT_ZoneProjectNetCorrections, TotalCorrections);
+}
+
+void UZoneProjectNetTelemetrySubsystem::FlushCsv()
+{
+	if (!bWriteCsv || (PendingConnectionRows.IsEmpty() && PendingClassRows.IsEmpty())) return;
+
+	// One pair of files per world, named after the map and the time it started
+
+	if (ConnectionCsvPath.IsEmpty())
+	{
+		const FString BaseName = FPaths::ProjectSavedDir() / TEXT("Telemetry") /
+			FString::Printf(TEXT("Net-%s-%s"), *GetWorld()->GetMapName(), *FDateTime::Now().ToString());
+
+		ConnectionCsvPath = BaseName + TEXT("-Connections.csv");
+		ClassCsvPath = BaseName + TEXT("-Classes.csv");
+
+		FFileHelper::SaveStringToFile(TEXT("Time,Connection,RoundTripMs,RoundTripP95Ms,JitterMs,InLossPct,OutLossPct,InBytesPerSec,OutBytesPerSec,")
+			TEXT("ReliableBufferMax,ReliableBufferTotal,MovesPerSec,CorrectionsPerSec,RpcsPerSec\n"), *ConnectionCsvPath);
+
+		FFileHelper::SaveStringToFile(TEXT("Time,Connection,Class,OutBytesPerSec\n"), *ClassCsvPath);
+	}
+
+	FFileHelper::SaveStringToFile(PendingConnectionRows, *ConnectionCsvPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+	FFileHelper::SaveStringToFile(PendingClassRows, *ClassCsvPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+
+	PendingConnectionRows.Reset();
+	PendingClassRows.Reset();
+}
+
+void UZoneProjectNetTelemetrySubsystem::RecordRpc(const AActor* Actor, const FName Rpc)
+{
+	UWorld* World = Actor ? Actor->GetWorld() : nullptr;
+	UZoneProjectNetTelemetrySubsystem* Subsystem = World ? World->GetSubsystem<UZoneProjectNetTelemetrySubsystem>() : nullptr;
+
+	if (!Subsystem || !Subsystem->bEnabled) return;
+
+	// Calls on actors without an owning connection are not charged to any client
+
+	if (UNetConnection* Connection = Actor->GetNetConnection())
+	{
+		Subsystem->Connections.FindOrAdd(Connection).PendingRpcCounts.FindOrAdd(Rpc)++;
+	}
+}
+
+void UZoneProjectNetTelemetrySubsystem::DumpStats() const
+{
+	UE_LOG(LogZoneProject, Log, TEXT("Net telemetry of %d connections in %s:"), Connections.Num(), *GetWorld()->GetMapName());
+
+	for (const TPair<TObjectKey<UNetConnection>, FZoneProjectConnectionTelemetry>& Pair : Connections)
+	{
+		const FZoneProjectConnectionTelemetry& Telemetry = Pair.Value;
+		if (Telemetry.RoundTrip.IsEmpty()) continue;
+
+		UE_LOG(LogZoneProject, Log, TEXT("  %s: round trip %.0f ms (p95 %.0f ms, jitter %.1f ms), loss %.1f%% in %.1f%% out, %d B/s in %d B/s out, ")
+			TEXT("reliable buffer %d max %d total, %.0f moves/s, %.2f corrections/s"), *Telemetry.Name, Telemetry.RoundTrip.Last(),
+			Telemetry.RoundTrip.GetPercentile(0.95), Telemetry.RoundTrip.GetStandardDeviation(), Telemetry.InLoss, Telemetry.OutLoss,
+			Telemetry.InBytesPerSecond, Telemetry.OutBytesPerSecond, Telemetry.ReliableBufferMax, Telemetry.ReliableBufferTotal,
+			Telemetry.MovesPerSecond, Telemetry.CorrectionsPerSecond);
+
+		TArray<TPair<FName, float>> Classes = Telemetry.OutBytesByClass.Array();
+		Classes.Sort([](const TPair<FName, float>& A, const TPair<FName, float>& B) { return A.Value > B.Value; });
+
+		for (int32 Index = 0; Index < FMath::Min(Classes.Num(), MaxDumpedClasses); ++Index)
+		{
+			UE_LOG(LogZoneProject, Log, TEXT("    %s: %.0f B/s"), *Classes[Index].Key.ToString(), Classes[Index].Value);
+		}
+
+		for (const TPair<FName, float>& Rpc : Telemetry.RpcRates)
+		{
+			UE_LOG(LogZoneProject, Log, TEXT("    %s: %.1f calls/s"), *Rpc.Key.ToString(), Rpc.Value);
+		}
+	}
+}
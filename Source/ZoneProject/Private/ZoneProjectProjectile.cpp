@@ -0,0 +1,133 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#include "ZoneProjectProjectile.h"
+#include "ZoneProjectProjectileSubsystem.h"
+#include "ZoneProjectSpatialHashSubsystem.h"
+#include "ZoneProjectWeapon.h"
+#include "Components/SphereComponent.h"
+#include "GameFramework/DamageType.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "Kismet/GameplayStatics.h"
+#include "Engine/World.h"
+
+AZoneProjectProjectile::AZoneProjectProjectile()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	// Pooled instances are created locally on every machine
+
+	bReplicates = false;
+
+	// Set up the collision component
+
+	Collision = CreateDefaultSubobject<USphereComponent>(TEXT("Collision"));
+	Collision->InitSphereRadius(5.f);
+	Collision->SetCollisionProfileName(FName(TEXT("Projectile")));
+	Collision->SetCanEverAffectNavigation(false);
+	RootComponent = Collision;
+
+	// Set up the movement component
+
+	Movement = CreateDefaultSubobject<UProjectileMovementComponent>(TEXT("Movement"));
+	Movement->SetUpdatedComponent(Collision);
+	Movement->InitialSpeed = 3000.f;
+	Movement->MaxSpeed = 3000.f;
+	Movement->ProjectileGravityScale = 0.f;
+	Movement->bRotationFollowsVelocity = true;
+	Movement->bAutoActivate = false;
+}
+
+void AZoneProjectProjectile::BeginPlay()
+{
+	Super::BeginPlay();
+
+	Collision->OnComponentHit.AddDynamic(this, &AZoneProjectProjectile::OnHit);
+}
+
+void AZoneProjectProjectile::OnHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp,
+	FVector NormalImpulse, const FHitResult& Hit)
+{
+	if (!bIsActive) return;
+
+	if (bDealDamage && HasAuthority() && OtherActor && OtherActor != GetInstigator())
+	{
+		const FVector Direction = Movement->Velocity.GetSafeNormal();
+		UGameplayStatics::ApplyPointDamage(OtherActor, Damage, Direction, Hit, GetInstigatorController(), this, UDamageType::StaticClass());
+	}
+	else if (const AZoneProjectWeapon* Weapon = Cast<AZoneProjectWeapon>(GetOwner()))
+	{
+		Weapon->ReportHit(OtherActor, LaunchTransform.GetLocation(), LaunchTransform.GetRotation().Vector());
+	}
+
+	OnImpact(Hit);
+	Release();
+}
+
+void AZoneProjectProjectile::Activate(const FTransform& Transform, AActor* InOwner, APawn* InInstigator)
+{
+	bIsActive = true;
+	ActivationTime = GetWorld()->GetTimeSeconds();
+	LaunchTransform = Transform;
+
+	SetOwner(InOwner);
+	SetInstigator(InInstigator);
+
+	// Ignore the shooter and everything attached to it
+
+	Collision->ClearMoveIgnoreActors();
+	if (InInstigator) Collision->IgnoreActorWhenMoving(InInstigator, true);
+	if (InOwner && InOwner != InInstigator) Collision->IgnoreActorWhenMoving(InOwner, true);
+
+	SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+
+	Movement->SetUpdatedComponent(Collision);
+	Movement->Velocity = Transform.GetRotation().Vector() * Movement->InitialSpeed;
+	Movement->Activate(true);
+	Movement->UpdateComponentVelocity();
+
+	// Index the projectile for proximity queries, hits are still detected by the collision sweep
+
+	if (UZoneProjectSpatialHashSubsystem* SpatialHash = GetWorld()->GetSubsystem<UZoneProjectSpatialHashSubsystem>())
+	{
+		SpatialHash->RegisterActor(this, ESpatialCategory::Projectile, Collision->GetScaledSphereRadius());
+	}
+
+	FTimerManager& TimerManager = GetWorldTimerManager();
+	TimerManager.SetTimer(LifeTimer, this, &AZoneProjectProjectile::Release, LifeTime, false);
+
+	OnLaunched();
+}
+
+void AZoneProjectProjectile::Deactivate()
+{
+	bIsActive = false;
+
+	GetWorldTimerManager().ClearTimer(LifeTimer);
+
+	Movement->StopMovementImmediately();
+	Movement->Deactivate();
+
+	if (UZoneProjectSpatialHashSubsystem* SpatialHash = GetWorld()->GetSubsystem<UZoneProjectSpatialHashSubsystem>())
+	{
+		SpatialHash->UnregisterActor(this);
+	}
+
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+}
+
+void AZoneProjectProjectile::Release()
+{
+	if (!bIsActive) return;
+
+	if (UZoneProjectProjectileSubsystem* Subsystem = GetWorld()->GetSubsystem<UZoneProjectProjectileSubsystem>())
+	{
+		Subsystem->ReleaseProjectile(this);
+	}
+	else
+	{
+		Destroy();
+	}
+}
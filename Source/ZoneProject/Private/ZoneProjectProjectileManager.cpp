@@ -0,0 +1,224 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#include "ZoneProjectProjectileManager.h"
+#include "ZoneProject/ZoneProject.h"
+#include "ZoneProjectCharacter.h"
+#include "ZoneProjectWeapon.h"
+#include "Async/ParallelFor.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/DamageType.h"
+#include "Kismet/GameplayStatics.h"
+#include "Materials/MaterialInterface.h"
+
+DECLARE_CYCLE_STAT(TEXT("Simulate Projectiles"), STAT_ZoneProjectSimulateProjectiles, STATGROUP_ZoneProject);
+DECLARE_CYCLE_STAT(TEXT("Resolve Projectiles"), STAT_ZoneProjectResolveProjectiles, STATGROUP_ZoneProject);
+DECLARE_CYCLE_STAT(TEXT("Update Projectile Visual"), STAT_ZoneProjectUpdateProjectileVisual, STATGROUP_ZoneProject);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Batched Projectiles"), STAT_ZoneProjectBatchedProjectiles, STATGROUP_ZoneProject);
+
+static TAutoConsoleVariable<bool> CVarParallelProjectiles(
+	TEXT("ZoneProject.Projectiles.Parallel"),
+	true,
+	TEXT("Sweep batched projectiles on worker threads"));
+
+/* Projectile collision channel defined in DefaultEngine.ini */
+static constexpr ECollisionChannel ECC_Projectile = ECC_GameTraceChannel1;
+
+void UZoneProjectProjectileManager::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+}
+
+void UZoneProjectProjectileManager::Deinitialize()
+{
+	VisualActor = nullptr;
+	Visual = nullptr;
+
+	Super::Deinitialize();
+}
+
+void UZoneProjectProjectileManager::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// A dedicated server never draws projectiles
+
+	if (InWorld.GetNetMode() == NM_DedicatedServer) return;
+
+	FActorSpawnParameters SpawnInfo;
+	SpawnInfo.ObjectFlags |= RF_Transient;
+
+	VisualActor = InWorld.SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnInfo);
+	if (!VisualActor) return;
+
+	Visual = NewObject<UInstancedStaticMeshComponent>(VisualActor, TEXT("ProjectileVisual"));
+	Visual->SetMobility(EComponentMobility::Movable);
+	Visual->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Visual->SetCastShadow(false);
+	Visual->SetCanEverAffectNavigation(false);
+	Visual->SetStaticMesh(VisualMesh.LoadSynchronous());
+	if (UMaterialInterface* Material = VisualMaterial.LoadSynchronous()) Visual->SetMaterial(0, Material);
+
+	VisualActor->SetRootComponent(Visual);
+	Visual->RegisterComponent();
+}
+
+void UZoneProjectProjectileManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SET_DWORD_STAT(STAT_ZoneProjectBatchedProjectiles, Positions.Num());
+
+	if (Positions.Num() > 0)
+	{
+		SimulateProjectiles(DeltaTime);
+		ResolveProjectiles();
+	}
+
+	UpdateVisual();
+}
+
+TStatId UZoneProjectProjectileManager::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UZoneProjectProjectileManager, STATGROUP_ZoneProject);
+}
+
+bool UZoneProjectProjectileManager::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UZoneProjectProjectileManager::LaunchProjectile(const FVector& Location, const FVector& Velocity, float LifeTime, float Damage,
+	APawn* Instigator, bool bDealDamage)
+{
+	Origins.Add(Location);
+	Positions.Add(Location);
+	Velocities.Add(Velocity);
+	LifeTimes.Add(LifeTime);
+	Damages.Add(Damage);
+	Instigators.Add(Instigator);
+	DealDamage.Add(bDealDamage && GetWorld()->GetNetMode() != NM_Client);
+}
+
+void UZoneProjectProjectileManager::RemoveProjectileAtSwap(const int32 Index)
+{
+	Origins.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Positions.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Velocities.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	LifeTimes.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Damages.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Instigators.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	DealDamage.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+}
+
+void UZoneProjectProjectileManager::SimulateProjectiles(const float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectSimulateProjectiles);
+
+	const int32 Num = Positions.Num();
+
+	// Resolve weak pointers on the game thread before going wide
+
+	IgnoredActors.SetNumUninitialized(Num, EAllowShrinking::No);
+	for (int32 Index = 0; Index < Num; ++Index) IgnoredActors[Index] = Instigators[Index].Get();
+
+	HitResults.SetNum(Num, EAllowShrinking::No);
+	HitFlags.SetNumUninitialized(Num, EAllowShrinking::No);
+
+	const UWorld* World = GetWorld();
+	const FCollisionShape Shape = FCollisionShape::MakeSphere(CollisionRadius);
+
+	// Scene queries only read the physics scene, so the sweeps can run concurrently while the game thread waits
+
+	const EParallelForFlags Flags = CVarParallelProjectiles.GetValueOnGameThread() ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread;
+
+	ParallelFor(TEXT("ZoneProjectProjectiles"), Num, ParallelBatchSize, [this, World, &Shape, DeltaTime](const int32 Index)
+	{
+		const FVector Start = Positions[Index];
+		const FVector End = Start + Velocities[Index] * DeltaTime;
+
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ZoneProjectProjectile), false, IgnoredActors[Index]);
+
+		HitFlags[Index] = World->SweepSingleByChannel(HitResults[Index], Start, End, FQuat::Identity, ECC_Projectile, Shape, QueryParams);
+
+		Positions[Index] = HitFlags[Index] ? HitResults[Index].Location : End;
+		LifeTimes[Index] -= DeltaTime;
+	}, Flags);
+}
+
+void UZoneProjectProjectileManager::ResolveProjectiles()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectResolveProjectiles);
+
+	// Iterate backwards so swap-removal doesn't skip elements
+
+	for (int32 Index = Positions.Num() - 1; Index >= 0; --Index)
+	{
+		if (HitFlags[Index])
+		{
+			AActor* HitActor = HitResults[Index].GetActor();
+			APawn* Instigator = Instigators[Index].Get();
+
+			if (HitActor && DealDamage[Index])
+			{
+				AController* InstigatorController = Instigator ? Instigator->GetController() : nullptr;
+
+				UGameplayStatics::ApplyPointDamage(HitActor, Damages[Index], Velocities[Index].GetSafeNormal(), HitResults[Index],
+					InstigatorController, Instigator, UDamageType::StaticClass());
+			}
+			else if (const AZoneProjectCharacter* Character = Cast<AZoneProjectCharacter>(Instigator))
+			{
+				// Locally predicted hits are validated by the server
+
+				if (const AZoneProjectWeapon* Weapon = Character->GetWeapon())
+				{
+					Weapon->ReportHit(HitActor, Origins[Index], Velocities[Index]);
+				}
+			}
+
+			RemoveProjectileAtSwap(Index);
+		}
+		else if (LifeTimes[Index] <= 0.f)
+		{
+			RemoveProjectileAtSwap(Index);
+		}
+	}
+}
+
+void UZoneProjectProjectileManager::UpdateVisual()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectUpdateProjectileVisual);
+
+	if (!Visual) return;
+
+	const int32 Num = Positions.Num();
+	const int32 Count = Visual->GetInstanceCount();
+	const int32 Existing = FMath::Min(Num, Count);
+
+	// Drop the surplus instances in one call, always from the end to avoid reindexing
+
+	if (Count > Num)
+	{
+		RemovedInstances.Reset();
+		for (int32 Index = Count - 1; Index >= Num; --Index) RemovedInstances.Add(Index);
+
+		Visual->RemoveInstances(RemovedInstances, true);
+	}
+
+	// Move the instances that are kept and append the missing ones in one call each
+
+	InstanceTransforms.SetNumUninitialized(Existing, EAllowShrinking::No);
+	AddedTransforms.SetNumUninitialized(Num - Existing, EAllowShrinking::No);
+
+	for (int32 Index = 0; Index < Num; ++Index)
+	{
+		const FTransform Transform(Velocities[Index].Rotation(), Positions[Index], VisualScale);
+
+		if (Index < Existing) InstanceTransforms[Index] = Transform;
+		else AddedTransforms[Index - Existing] = Transform;
+	}
+
+	if (Existing > 0) Visual->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, true);
+	if (AddedTransforms.Num() > 0) Visual->AddInstances(AddedTransforms, false, true, false);
+}
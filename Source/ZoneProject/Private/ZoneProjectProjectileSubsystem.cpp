@@ -0,0 +1,169 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#include "ZoneProjectProjectileSubsystem.h"
+#include "ZoneProject/ZoneProject.h"
+#include "ZoneProjectProjectile.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Acquire Projectile"), STAT_ZoneProjectAcquireProjectile, STATGROUP_ZoneProject);
+DECLARE_CYCLE_STAT(TEXT("Release Projectile"), STAT_ZoneProjectReleaseProjectile, STATGROUP_ZoneProject);
+
+static FAutoConsoleCommandWithWorld GProjectilePoolStatsCommand(
+	TEXT("ZoneProject.Projectiles.PoolStats"),
+	TEXT("Print hits, misses and peak usage of every projectile pool in the current world"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UZoneProjectProjectileSubsystem* Subsystem = World ? World->GetSubsystem<UZoneProjectProjectileSubsystem>() : nullptr)
+		{
+			Subsystem->DumpStats();
+		}
+	}));
+
+void UZoneProjectProjectileSubsystem::Deinitialize()
+{
+	DumpStats();
+
+	Pools.Empty();
+
+	Super::Deinitialize();
+}
+
+AZoneProjectProjectile* UZoneProjectProjectileSubsystem::SpawnInstance(TSubclassOf<AZoneProjectProjectile> ProjectileClass) const
+{
+	FActorSpawnParameters SpawnInfo;
+
+	SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnInfo.ObjectFlags |= RF_Transient;
+
+	AZoneProjectProjectile* Projectile = GetWorld()->SpawnActor<AZoneProjectProjectile>(ProjectileClass, FTransform::Identity, SpawnInfo);
+	if (Projectile) Projectile->Deactivate();
+
+	return Projectile;
+}
+
+void UZoneProjectProjectileSubsystem::WarmUp(TSubclassOf<AZoneProjectProjectile> ProjectileClass)
+{
+	if (!ProjectileClass) return;
+
+	FProjectilePool& Pool = Pools.FindOrAdd(ProjectileClass);
+
+	const int32 PoolSize = GetDefault<AZoneProjectProjectile>(ProjectileClass)->PoolSize;
+
+	while (Pool.Num() < PoolSize)
+	{
+		AZoneProjectProjectile* Projectile = SpawnInstance(ProjectileClass);
+		if (!Projectile) break;
+
+		Pool.Available.Add(Projectile);
+	}
+}
+
+AZoneProjectProjectile* UZoneProjectProjectileSubsystem::AcquireProjectile(TSubclassOf<AZoneProjectProjectile> ProjectileClass,
+	const FTransform& Transform, AActor* Owner, APawn* Instigator)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectAcquireProjectile);
+
+	if (!ProjectileClass) return nullptr;
+
+	FProjectilePool& Pool = Pools.FindOrAdd(ProjectileClass);
+	const AZoneProjectProjectile* Defaults = GetDefault<AZoneProjectProjectile>(ProjectileClass);
+
+	AZoneProjectProjectile* Projectile = nullptr;
+
+	// Drop instances destroyed externally (e.g. by a level streaming out)
+
+	while (Pool.Available.Num() > 0 && !Projectile)
+	{
+		Projectile = Pool.Available.Pop(EAllowShrinking::No);
+		if (!IsValid(Projectile)) Projectile = nullptr;
+	}
+
+	if (!Projectile)
+	{
+		Pool.Active.RemoveAllSwap([](const TObjectPtr<AZoneProjectProjectile>& Active) { return !IsValid(Active); });
+	}
+
+	if (Projectile)
+	{
+		Pool.Stats.Hits++;
+	}
+	else if (Defaults->MaxPoolSize == 0 || Pool.Num() < Defaults->MaxPoolSize || Defaults->OverflowPolicy == EProjectilePoolOverflow::Grow)
+	{
+		Pool.Stats.Misses++;
+		Projectile = SpawnInstance(ProjectileClass);
+	}
+	else if (Defaults->OverflowPolicy == EProjectilePoolOverflow::RecycleOldest && Pool.Active.Num() > 0)
+	{
+		// Steal the projectile that has been in flight for the longest time
+
+		int32 OldestIndex = 0;
+
+		for (int32 Index = 1; Index < Pool.Active.Num(); ++Index)
+		{
+			if (Pool.Active[Index]->GetActivationTime() < Pool.Active[OldestIndex]->GetActivationTime()) OldestIndex = Index;
+		}
+
+		Projectile = Pool.Active[OldestIndex];
+		Pool.Active.RemoveAtSwap(OldestIndex, 1, EAllowShrinking::No);
+		Projectile->Deactivate();
+
+		Pool.Stats.Recycled++;
+	}
+	else
+	{
+		Pool.Stats.Rejected++;
+		return nullptr;
+	}
+
+	if (!Projectile) return nullptr;
+
+	Projectile->Activate(Transform, Owner, Instigator);
+
+	Pool.Active.Add(Projectile);
+	Pool.Stats.PeakActive = FMath::Max(Pool.Stats.PeakActive, Pool.Active.Num());
+
+	return Projectile;
+}
+
+void UZoneProjectProjectileSubsystem::ReleaseProjectile(AZoneProjectProjectile* Projectile)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectReleaseProjectile);
+
+	if (!Projectile) return;
+
+	if (FProjectilePool* Pool = Pools.Find(Projectile->GetClass()))
+	{
+		// Releasing a projectile twice must not hand it out to two shooters
+
+		if (Pool->Active.RemoveSingleSwap(Projectile, EAllowShrinking::No) == 0 && Pool->Available.Contains(Projectile)) return;
+
+		Projectile->Deactivate();
+		Pool->Available.Add(Projectile);
+	}
+	else
+	{
+		Projectile->Deactivate();
+		Projectile->Destroy();
+	}
+}
+
+FProjectilePoolStats UZoneProjectProjectileSubsystem::GetPoolStats(TSubclassOf<AZoneProjectProjectile> ProjectileClass) const
+{
+	const FProjectilePool* Pool = Pools.Find(ProjectileClass);
+	return Pool ? Pool->Stats : FProjectilePoolStats();
+}
+
+void UZoneProjectProjectileSubsystem::DumpStats() const
+{
+	const UWorld* World = GetWorld();
+	const FString MapName = World ? World->GetMapName() : FString();
+
+	for (const TPair<TSubclassOf<AZoneProjectProjectile>, FProjectilePool>& Pair : Pools)
+	{
+		const FProjectilePool& Pool = Pair.Value;
+
+		UE_LOG(LogZoneProject, Log, TEXT("Projectile pool [%s] on %s: Hits: %d; Misses: %d; Recycled: %d; Rejected: %d; Peak Active: %d; Size: %d"),
+			*GetNameSafe(Pair.Key), *MapName, Pool.Stats.Hits, Pool.Stats.Misses, Pool.Stats.Recycled, Pool.Stats.Rejected,
+			Pool.Stats.PeakActive, Pool.Num());
+	}
+}
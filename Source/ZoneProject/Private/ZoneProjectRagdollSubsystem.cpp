@@ -0,0 +1,123 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#include "ZoneProjectRagdollSubsystem.h"
+#include "ZoneProject/ZoneProject.h"
+#include "ZoneProjectCharacter.h"
+#include "Animation/AnimMontage.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Update Ragdolls"), STAT_ZoneProjectUpdateRagdolls, STATGROUP_ZoneProject);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Simulated Ragdolls"), STAT_ZoneProjectSimulatedRagdolls, STATGROUP_ZoneProject);
+
+void UZoneProjectRagdollSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SET_DWORD_STAT(STAT_ZoneProjectSimulatedRagdolls, Ragdolls.Num());
+
+	if (Ragdolls.Num() == 0) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectUpdateRagdolls);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	// Iterate backwards so swap-removal doesn't skip elements
+
+	for (int32 Index = Ragdolls.Num() - 1; Index >= 0; --Index)
+	{
+		FZoneProjectRagdoll& Ragdoll = Ragdolls[Index];
+		const AZoneProjectCharacter* Character = Ragdoll.Character.Get();
+
+		if (!Character)
+		{
+			Ragdolls.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+			continue;
+		}
+
+		const float Speed = Character->GetMesh()->GetPhysicsLinearVelocity().Size();
+
+		Ragdoll.SettledTime = Speed < SettleSpeed ? Ragdoll.SettledTime + DeltaTime : 0.f;
+
+		if (Ragdoll.SettledTime >= SettleTime || Now - Ragdoll.StartTime >= MaxSimulationTime)
+		{
+			SleepRagdollAtSwap(Index);
+		}
+	}
+}
+
+TStatId UZoneProjectRagdollSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UZoneProjectRagdollSubsystem, STATGROUP_ZoneProject);
+}
+
+bool UZoneProjectRagdollSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UZoneProjectRagdollSubsystem::SleepRagdollAtSwap(const int32 Index)
+{
+	if (const AZoneProjectCharacter* Character = Ragdolls[Index].Character.Get())
+	{
+		// Take the bodies out of the physics simulation and keep the settled pose instead of going back to the animation
+
+		USkeletalMeshComponent* Mesh = Character->GetMesh();
+
+		Mesh->SetAllBodiesSimulatePhysics(false);
+		Mesh->bNoSkeletonUpdate = true;
+	}
+
+	Ragdolls.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+}
+
+void UZoneProjectRagdollSubsystem::StartDeathPose(AZoneProjectCharacter* Character)
+{
+	if (!Character) return;
+
+	// Nobody sees the body on a dedicated server, the capsule has no collision anymore anyway
+
+	if (GetWorld()->GetNetMode() == NM_DedicatedServer && !bSimulateOnDedicatedServer) return;
+
+	USkeletalMeshComponent* Mesh = Character->GetMesh();
+
+	if (Ragdolls.Num() < MaxRagdolls)
+	{
+		Mesh->SetCollisionProfileName(FName(TEXT("Ragdoll")));
+		Mesh->SetAllBodiesSimulatePhysics(true);
+		Mesh->WakeAllRigidBodies();
+
+		FZoneProjectRagdoll& Ragdoll = Ragdolls.AddDefaulted_GetRef();
+		Ragdoll.Character = Character;
+		Ragdoll.StartTime = GetWorld()->GetTimeSeconds();
+
+		return;
+	}
+
+	// Over the budget, play the animated death if there is one, otherwise keep the current pose
+
+	if (UAnimMontage* DeathMontage = Character->GetDeathMontage())
+	{
+		Character->PlayAnimMontage(DeathMontage);
+	}
+	else
+	{
+		Mesh->bPauseAnims = true;
+	}
+}
+
+void UZoneProjectRagdollSubsystem::StopDeathPose(AZoneProjectCharacter* Character)
+{
+	const int32 Index = Ragdolls.IndexOfByPredicate([Character](const FZoneProjectRagdoll& Ragdoll)
+	{
+		return Ragdoll.Character.Get() == Character;
+	});
+
+	if (Index != INDEX_NONE) Ragdolls.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+
+	if (!Character) return;
+
+	if (UAnimMontage* DeathMontage = Character->GetDeathMontage()) Character->StopAnimMontage(DeathMontage);
+	Character->GetMesh()->bPauseAnims = false;
+	Character->GetMesh()->bNoSkeletonUpdate = false;
+}
@@ -0,0 +1,343 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#include "ZoneProjectReplicationGraph.h"
+#include "ZoneProject/ZoneProject.h"
+#include "ZoneProjectCharacter.h"
+#include "ZoneProjectDropItem.h"
+#include "ZoneProjectProjectile.h"
+#include "ZoneProjectSpatialHashSubsystem.h"
+#include "ZoneProjectWeapon.h"
+#include "Engine/LevelScriptActor.h"
+#include "GameFramework/Info.h"
+#include "GameFramework/PlayerController.h"
+#include "UObject/UObjectIterator.h"
+
+void UZoneProjectReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// Classes with a known role in the game, everything else is routed by its relevancy flags
+
+	ClassRepNodePolicies.Set(AZoneProjectCharacter::StaticClass(), EZoneProjectRepNodeMapping::CameraFootprint);
+	ClassRepNodePolicies.Set(AZoneProjectDropItem::StaticClass(), EZoneProjectRepNodeMapping::CameraFootprint);
+	ClassRepNodePolicies.Set(AZoneProjectWeapon::StaticClass(), EZoneProjectRepNodeMapping::NotRouted);
+	ClassRepNodePolicies.Set(AZoneProjectProjectile::StaticClass(), EZoneProjectRepNodeMapping::NotRouted);
+	ClassRepNodePolicies.Set(APlayerController::StaticClass(), EZoneProjectRepNodeMapping::NotRouted);
+	ClassRepNodePolicies.Set(ALevelScriptActor::StaticClass(), EZoneProjectRepNodeMapping::NotRouted);
+	ClassRepNodePolicies.Set(AInfo::StaticClass(), EZoneProjectRepNodeMapping::RelevantAllConnections);
+
+	ViewFootprint = ComputeViewFootprint();
+
+	const float FootprintRadius = ViewFootprint.GetRadius();
+	const float CullDistanceSquared = FMath::Square(FootprintRadius + RelevancyMargin);
+
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+
+		const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject(false));
+		if (!ActorCDO || !ActorCDO->GetIsReplicated()) continue;
+
+		// Skip the intermediate classes of blueprint compilation
+
+		if (Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_"))) continue;
+
+		const EZoneProjectRepNodeMapping Mapping = GetMappingPolicy(Class);
+		const bool bSpatialize = Mapping >= EZoneProjectRepNodeMapping::Spatialize_Static;
+
+		// Everything the grid holds is culled by what the camera can see instead of the per-class distance.
+		// The camera footprint node culls its actors itself
+
+		FClassReplicationInfo ClassInfo;
+		ClassInfo.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(ActorCDO->NetUpdateFrequency);
+		if (bSpatialize) ClassInfo.SetCullDistanceSquared(CullDistanceSquared);
+
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+	}
+
+	UE_LOG(LogZoneProject, Log, TEXT("Replication graph camera footprint %.0f..%.0f cm forward, radius %.0f cm"),
+		ViewFootprint.NearForward, ViewFootprint.FarForward, FootprintRadius);
+}
+
+void UZoneProjectReplicationGraph::InitGlobalGraphNodes()
+{
+	// Cells as large as the camera footprint keep the number of cells gathered per connection small
+
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = ViewFootprint.GetRadius();
+	GridNode->SpatialBias = FVector2D(-UE_OLD_WORLD_MAX, -UE_OLD_WORLD_MAX);
+
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+
+	AddGlobalGraphNode(AlwaysRelevantNode);
+
+	// Dormant actors are skipped per connection once their last state is sent, so listing them for everyone is cheap
+
+	DormantCharacterNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+
+	AddGlobalGraphNode(DormantCharacterNode);
+}
+
+void UZoneProjectReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	UZoneProjectReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantForConnectionNode =
+		CreateNewNode<UZoneProjectReplicationGraphNode_AlwaysRelevant_ForConnection>();
+
+	AddConnectionGraphNode(AlwaysRelevantForConnectionNode, RepGraphConnection);
+
+	UZoneProjectReplicationGraphNode_CameraFootprint* CameraFootprintNode = CreateNewNode<UZoneProjectReplicationGraphNode_CameraFootprint>();
+
+	AddConnectionGraphNode(CameraFootprintNode, RepGraphConnection);
+}
+
+void UZoneProjectReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	switch (GetMappingPolicy(ActorInfo.Class))
+	{
+	case EZoneProjectRepNodeMapping::NotRouted:
+	case EZoneProjectRepNodeMapping::CameraFootprint:
+		break;
+
+	case EZoneProjectRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+
+	case EZoneProjectRepNodeMapping::Spatialize_Static:
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+
+	case EZoneProjectRepNodeMapping::Spatialize_Dynamic:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+
+	case EZoneProjectRepNodeMapping::Spatialize_Dormancy:
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+	}
+
+	// Pooled characters leave the spatial hash while dormant, the dormant character node keeps their channels open
+
+	if (ActorInfo.Actor->IsA<AZoneProjectCharacter>())
+	{
+		if (ActorInfo.Actor->NetDormancy > DORM_Awake) DormantCharacterNode->NotifyAddNetworkActor(ActorInfo);
+		GlobalInfo.Events.DormancyChange.AddUObject(this, &UZoneProjectReplicationGraph::OnCharacterDormancyChanged);
+	}
+
+	// The weapon is relevant exactly when its character is
+
+	if (const AZoneProjectWeapon* Weapon = Cast<AZoneProjectWeapon>(ActorInfo.Actor))
+	{
+		if (AActor* Owner = Weapon->GetOwner()) GlobalActorReplicationInfoMap.AddDependentActor(Owner, ActorInfo.Actor);
+	}
+}
+
+void UZoneProjectReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	switch (GetMappingPolicy(ActorInfo.Class))
+	{
+	case EZoneProjectRepNodeMapping::NotRouted:
+	case EZoneProjectRepNodeMapping::CameraFootprint:
+		break;
+
+	case EZoneProjectRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+
+	case EZoneProjectRepNodeMapping::Spatialize_Static:
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+
+	case EZoneProjectRepNodeMapping::Spatialize_Dynamic:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+
+	case EZoneProjectRepNodeMapping::Spatialize_Dormancy:
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+	}
+
+	if (ActorInfo.Actor->IsA<AZoneProjectCharacter>()) DormantCharacterNode->NotifyRemoveNetworkActor(ActorInfo, false);
+
+	if (const AZoneProjectWeapon* Weapon = Cast<AZoneProjectWeapon>(ActorInfo.Actor))
+	{
+		if (AActor* Owner = Weapon->GetOwner()) GlobalActorReplicationInfoMap.RemoveDependentActor(Owner, ActorInfo.Actor);
+	}
+}
+
+EZoneProjectRepNodeMapping UZoneProjectReplicationGraph::GetMappingPolicy(const UClass* Class)
+{
+	if (const EZoneProjectRepNodeMapping* Mapping = ClassRepNodePolicies.Get(Class)) return *Mapping;
+
+	// Fall back to the relevancy flags of the class and remember the result
+
+	const AActor* ActorCDO = Class->GetDefaultObject<AActor>();
+
+	EZoneProjectRepNodeMapping Mapping = EZoneProjectRepNodeMapping::Spatialize_Dynamic;
+
+	if (ActorCDO->bAlwaysRelevant) Mapping = EZoneProjectRepNodeMapping::RelevantAllConnections;
+	else if (ActorCDO->bOnlyRelevantToOwner) Mapping = EZoneProjectRepNodeMapping::NotRouted;
+	else if (ActorCDO->NetDormancy == DORM_Initial) Mapping = EZoneProjectRepNodeMapping::Spatialize_Dormancy;
+
+	ClassRepNodePolicies.Set(Class, Mapping);
+
+	return Mapping;
+}
+
+void UZoneProjectReplicationGraph::OnCharacterDormancyChanged(FActorRepListType Actor, FGlobalActorReplicationInfo& GlobalInfo,
+	ENetDormancy NewValue, ENetDormancy OldValue)
+{
+	const bool bWasDormant = OldValue > DORM_Awake;
+	const bool bIsDormant = NewValue > DORM_Awake;
+
+	if (bIsDormant == bWasDormant) return;
+
+	if (bIsDormant)
+	{
+		DormantCharacterNode->NotifyAddNetworkActor(FNewReplicatedActorInfo(Actor));
+	}
+	else
+	{
+		DormantCharacterNode->NotifyRemoveNetworkActor(FNewReplicatedActorInfo(Actor));
+	}
+}
+
+FZoneProjectViewFootprint UZoneProjectReplicationGraph::ComputeViewFootprint() const
+{
+	FZoneProjectViewFootprint Footprint;
+
+	// Camera position relative to the pawn it looks at
+
+	const float Pitch = FMath::DegreesToRadians(FMath::Abs(CameraPitch));
+	const float Height = CameraArmLength * FMath::Sin(Pitch);
+	const float Back = CameraArmLength * FMath::Cos(Pitch);
+
+	const float HalfHorizontal = FMath::DegreesToRadians(CameraFieldOfView * 0.5f);
+	const float HalfVertical = FMath::Atan(FMath::Tan(HalfHorizontal) / CameraAspectRatio);
+
+	// Project the screen edges on the ground. A view reaching the horizon is not bounded
+
+	auto ProjectEdge = [Height, Back, HalfHorizontal, HalfVertical](const float Angle, float& OutForward, float& OutHalfWidth)
+	{
+		if (Angle <= UE_KINDA_SMALL_NUMBER)
+		{
+			OutForward = UE_OLD_WORLD_MAX;
+			OutHalfWidth = UE_OLD_WORLD_MAX;
+			return;
+		}
+
+		const float Slant = Height / FMath::Sin(Angle);
+
+		OutForward = Height / FMath::Tan(Angle) - Back;
+		OutHalfWidth = Slant * FMath::Cos(HalfVertical) * FMath::Tan(HalfHorizontal);
+	};
+
+	ProjectEdge(Pitch + HalfVertical, Footprint.NearForward, Footprint.NearHalfWidth);
+	ProjectEdge(Pitch - HalfVertical, Footprint.FarForward, Footprint.FarHalfWidth);
+
+	return Footprint;
+}
+
+bool FZoneProjectViewFootprint::Contains(const FVector2D& Point, const float Margin) const
+{
+	if (Point.X < NearForward - Margin || Point.X > FarForward + Margin) return false;
+
+	// The half width grows linearly from the bottom to the top edge of the screen
+
+	const float Alpha = FMath::Clamp((Point.X - NearForward) / FMath::Max(FarForward - NearForward, UE_KINDA_SMALL_NUMBER), 0.f, 1.f);
+
+	return FMath::Abs(Point.Y) <= FMath::Lerp(NearHalfWidth, FarHalfWidth, Alpha) + Margin;
+}
+
+float FZoneProjectViewFootprint::GetRadius() const
+{
+	const float NearRadius = FMath::Sqrt(FMath::Square(NearForward) + FMath::Square(NearHalfWidth));
+	const float FarRadius = FMath::Sqrt(FMath::Square(FarForward) + FMath::Square(FarHalfWidth));
+
+	return FMath::Min(FMath::Max(NearRadius, FarRadius), UE_OLD_WORLD_MAX);
+}
+
+void UZoneProjectReplicationGraphNode_AlwaysRelevant_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	// The base node adds the controllers and view targets of the connection
+
+	Super::GatherActorListsForConnection(Params);
+
+	PawnActors.Reset();
+
+	for (const FNetViewer& Viewer : Params.Viewers)
+	{
+		const APlayerController* PlayerController = Cast<APlayerController>(Viewer.InViewer);
+		AZoneProjectCharacter* Character = PlayerController ? Cast<AZoneProjectCharacter>(PlayerController->GetPawn()) : nullptr;
+
+		if (!Character) continue;
+
+		PawnActors.ConditionalAdd(Character);
+
+		if (AZoneProjectWeapon* Weapon = Character->GetWeapon()) PawnActors.ConditionalAdd(Weapon);
+	}
+
+	if (PawnActors.Num() > 0) Params.OutGatheredReplicationLists.AddReplicationActorList(PawnActors);
+}
+
+void UZoneProjectReplicationGraphNode_CameraFootprint::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	FootprintActors.Reset();
+
+	const UZoneProjectReplicationGraph* Graph = CastChecked<UZoneProjectReplicationGraph>(GetOuter());
+
+	UWorld* World = Graph->GetWorld();
+	const UZoneProjectSpatialHashSubsystem* SpatialHash = World ? World->GetSubsystem<UZoneProjectSpatialHashSubsystem>() : nullptr;
+
+	if (!SpatialHash) return;
+
+	const FZoneProjectViewFootprint& Footprint = Graph->GetViewFootprint();
+
+	const float Yaw = FMath::DegreesToRadians(Graph->CameraYaw);
+	const FVector2D Forward(FMath::Cos(Yaw), FMath::Sin(Yaw));
+	const FVector2D Right(-Forward.Y, Forward.X);
+
+	const float FireMargin = Graph->RelevancyMargin + Graph->FireEventMargin;
+
+	for (const FNetViewer& Viewer : Params.Viewers)
+	{
+		// The footprint follows the pawn, the camera location on the server lags behind the client camera updates
+
+		const FVector2D Origin(Viewer.ViewTarget ? Viewer.ViewTarget->GetActorLocation() : Viewer.ViewLocation);
+
+		// Query the bounding box of the footprint grown by the larger margin, then test the trapezoid
+
+		FBox2D Bounds(ForceInit);
+
+		for (const FVector2D& Corner : {
+			FVector2D(Footprint.NearForward, -Footprint.NearHalfWidth), FVector2D(Footprint.NearForward, Footprint.NearHalfWidth),
+			FVector2D(Footprint.FarForward, -Footprint.FarHalfWidth), FVector2D(Footprint.FarForward, Footprint.FarHalfWidth) })
+		{
+			Bounds += Origin + Forward * Corner.X + Right * Corner.Y;
+		}
+
+		SpatialHash->QueryBox(Bounds.ExpandBy(FireMargin), ESpatialCategory::Character | ESpatialCategory::DropItem, QueryActors);
+
+		for (AActor* Actor : QueryActors)
+		{
+			if (!Actor->GetIsReplicated() || Actor->IsActorBeingDestroyed()) continue;
+
+			const FVector2D Offset = FVector2D(Actor->GetActorLocation()) - Origin;
+			const FVector2D Point(Offset | Forward, Offset | Right);
+
+			// Shots of a character out of the screen can still fly into it
+
+			const AZoneProjectCharacter* Character = Cast<AZoneProjectCharacter>(Actor);
+			const bool bFiring = Character && Character->GetWeapon() && Character->GetWeapon()->IsFiring();
+
+			if (!Footprint.Contains(Point, bFiring ? FireMargin : Graph->RelevancyMargin)) continue;
+
+			if (Params.Viewers.Num() > 1) FootprintActors.ConditionalAdd(Actor); else FootprintActors.Add(Actor);
+		}
+	}
+
+	if (FootprintActors.Num() > 0) Params.OutGatheredReplicationLists.AddReplicationActorList(FootprintActors);
+}
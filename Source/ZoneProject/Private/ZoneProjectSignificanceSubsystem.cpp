@@ -0,0 +1,241 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#include "ZoneProjectSignificanceSubsystem.h"
+#include "ZoneProject/ZoneProject.h"
+#include "ZoneProjectAnimationBudgetSubsystem.h"
+#include "AIController.h"
+#include "BrainComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "SkeletalMeshComponentBudgeted.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+
+DECLARE_CYCLE_STAT(TEXT("Update Significance"), STAT_ZoneProjectUpdateSignificance, STATGROUP_ZoneProject);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Significance Actors"), STAT_ZoneProjectSignificanceActors, STATGROUP_ZoneProject);
+
+static FAutoConsoleCommandWithWorld GSignificanceStatsCommand(
+	TEXT("ZoneProject.Significance.Stats"),
+	TEXT("Print the number of actors in every significance bucket in the current world"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UZoneProjectSignificanceSubsystem* Subsystem = World ? World->GetSubsystem<UZoneProjectSignificanceSubsystem>() : nullptr)
+		{
+			Subsystem->DumpStats();
+		}
+	}));
+
+void UZoneProjectSignificanceSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SET_DWORD_STAT(STAT_ZoneProjectSignificanceActors, Entries.Num());
+
+	if (Entries.Num() == 0 || Buckets.Num() == 0) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectUpdateSignificance);
+
+	GatherViewLocations();
+
+	// Re-evaluate a fixed number of actors per frame in a round robin so a large horde has a flat cost
+
+	int32 Budget = FMath::Min(MaxUpdatesPerFrame, Entries.Num());
+
+	while (Budget-- > 0 && Entries.Num() > 0)
+	{
+		if (Cursor >= Entries.Num()) Cursor = 0;
+
+		FZoneProjectSignificanceEntry& Entry = Entries[Cursor];
+		AActor* Actor = Entry.Actor.Get();
+
+		if (!Actor)
+		{
+			// Destroyed without unregistering, the swapped-in entry is evaluated at the same cursor
+
+			EntryIndices.Remove(Entry.Key);
+			Entries.RemoveAtSwap(Cursor, 1, EAllowShrinking::No);
+			if (Entries.IsValidIndex(Cursor)) EntryIndices.Add(Entries[Cursor].Key, Cursor);
+			continue;
+		}
+
+		const int32 Bucket = EvaluateBucket(Actor, Entry.Bucket);
+
+		if (Bucket != Entry.Bucket)
+		{
+			Entry.Bucket = Bucket;
+			ApplyBucket(Actor, Buckets[Bucket]);
+
+			// Distant and off-screen characters share the poses of a few leaders
+
+			if (ACharacter* Character = Cast<ACharacter>(Actor))
+			{
+				if (UZoneProjectAnimationBudgetSubsystem* AnimationBudget = GetWorld()->GetSubsystem<UZoneProjectAnimationBudgetSubsystem>())
+				{
+					AnimationBudget->UpdateSharing(Character, Bucket);
+				}
+			}
+		}
+
+		Cursor++;
+	}
+}
+
+TStatId UZoneProjectSignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UZoneProjectSignificanceSubsystem, STATGROUP_ZoneProject);
+}
+
+bool UZoneProjectSignificanceSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UZoneProjectSignificanceSubsystem::GatherViewLocations()
+{
+	ViewLocations.Reset();
+
+	// The camera is top-down, so the view target location is the center of what the player sees
+
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController* PlayerController = Iterator->Get();
+		const AActor* ViewTarget = PlayerController ? PlayerController->GetViewTarget() : nullptr;
+
+		if (ViewTarget) ViewLocations.Add(ViewTarget->GetActorLocation());
+	}
+}
+
+int32 UZoneProjectSignificanceSubsystem::EvaluateBucket(const AActor* Actor, const int32 CurrentBucket) const
+{
+	// Players are always fully significant
+
+	const APawn* Pawn = Cast<APawn>(Actor);
+	if (Pawn && Pawn->IsPlayerControlled()) return 0;
+
+	const int32 LastBucket = Buckets.Num() - 1;
+
+	if (ViewLocations.Num() == 0) return LastBucket;
+
+	const FVector Location = Actor->GetActorLocation();
+
+	float MinDistanceSquared = TNumericLimits<float>::Max();
+	for (const FVector& ViewLocation : ViewLocations) MinDistanceSquared = FMath::Min(MinDistanceSquared, FVector::DistSquared2D(Location, ViewLocation));
+
+	const float Distance = FMath::Sqrt(MinDistanceSquared);
+
+	int32 Bucket = LastBucket;
+
+	for (int32 Index = 0; Index < LastBucket; ++Index)
+	{
+		if (Distance <= Buckets[Index].MaxDistance)
+		{
+			Bucket = Index;
+			break;
+		}
+	}
+
+	// Only demote once the actor is clearly past the edge of its current bucket
+
+	if (Buckets.IsValidIndex(CurrentBucket) && Bucket > CurrentBucket && Distance <= Buckets[CurrentBucket].MaxDistance + HysteresisDistance)
+	{
+		Bucket = CurrentBucket;
+	}
+
+	// Off-screen actors on clients can be throttled harder, nothing is visible from their missed frames
+
+	if (bDemoteNotRendered && GetWorld()->GetNetMode() == NM_Client && !Actor->WasRecentlyRendered(0.5f))
+	{
+		Bucket = FMath::Min(Bucket + 1, LastBucket);
+	}
+
+	return Bucket;
+}
+
+void UZoneProjectSignificanceSubsystem::ApplyBucket(AActor* Actor, const FSignificanceBucket& Bucket)
+{
+	Actor->SetActorTickInterval(Bucket.TickInterval);
+
+	if (const ACharacter* Character = Cast<ACharacter>(Actor))
+	{
+		// The budget allocator owns the tick rate of the meshes registered with it
+
+		USkeletalMeshComponent* Mesh = Character->GetMesh();
+		const USkeletalMeshComponentBudgeted* BudgetedMesh = Cast<USkeletalMeshComponentBudgeted>(Mesh);
+
+		if (Mesh && (!BudgetedMesh || BudgetedMesh->GetAnimationBudgetHandle() == INDEX_NONE))
+		{
+			Mesh->SetComponentTickInterval(Bucket.AnimationTickInterval);
+		}
+
+		if (UCharacterMovementComponent* Movement = Character->GetCharacterMovement())
+		{
+			Movement->SetComponentTickInterval(Bucket.MovementTickInterval);
+		}
+
+		if (AAIController* AIController = Cast<AAIController>(Character->GetController()))
+		{
+			AIController->SetActorTickInterval(Bucket.TickInterval);
+
+			if (UBrainComponent* Brain = AIController->GetBrainComponent())
+			{
+				Brain->SetComponentTickInterval(Bucket.TickInterval);
+			}
+		}
+	}
+}
+
+void UZoneProjectSignificanceSubsystem::RegisterActor(AActor* Actor)
+{
+	if (!Actor || EntryIndices.Contains(Actor)) return;
+
+	FZoneProjectSignificanceEntry& Entry = Entries.AddDefaulted_GetRef();
+	Entry.Actor = Actor;
+	Entry.Key = Actor;
+
+	EntryIndices.Add(Actor, Entries.Num() - 1);
+}
+
+void UZoneProjectSignificanceSubsystem::UnregisterActor(AActor* Actor)
+{
+	int32 Index;
+	if (!EntryIndices.RemoveAndCopyValue(Actor, Index)) return;
+
+	// Restore the full tick rate in case the actor keeps living outside of the subsystem
+
+	if (Entries[Index].Bucket != INDEX_NONE) ApplyBucket(Actor, FSignificanceBucket());
+
+	Entries.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+
+	if (Entries.IsValidIndex(Index))
+	{
+		EntryIndices.Add(Entries[Index].Key, Index);
+	}
+}
+
+int32 UZoneProjectSignificanceSubsystem::GetActorBucket(const AActor* Actor) const
+{
+	const int32* Index = EntryIndices.Find(Actor);
+	return Index ? Entries[*Index].Bucket : INDEX_NONE;
+}
+
+void UZoneProjectSignificanceSubsystem::DumpStats() const
+{
+	TArray<int32> Counts;
+	Counts.SetNumZeroed(Buckets.Num());
+
+	int32 NotEvaluated = 0;
+
+	for (const FZoneProjectSignificanceEntry& Entry : Entries)
+	{
+		if (Counts.IsValidIndex(Entry.Bucket)) Counts[Entry.Bucket]++; else NotEvaluated++;
+	}
+
+	UE_LOG(LogZoneProject, Log, TEXT("Significance of %d actors in %s (%d not evaluated yet):"), Entries.Num(), *GetWorld()->GetMapName(), NotEvaluated);
+
+	for (int32 Index = 0; Index < Buckets.Num(); ++Index)
+	{
+		UE_LOG(LogZoneProject, Log, TEXT("  Bucket %d (up to %.0f cm, tick %.2f s): %d actors"), Index, Buckets[Index].MaxDistance,
+			Buckets[Index].TickInterval, Counts[Index]);
+	}
+}
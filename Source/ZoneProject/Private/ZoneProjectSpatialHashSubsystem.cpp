@@ -0,0 +1,271 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#include "ZoneProjectSpatialHashSubsystem.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Update Spatial Hash"), STAT_ZoneProjectUpdateSpatialHash, STATGROUP_ZoneProject);
+DECLARE_CYCLE_STAT(TEXT("Query Spatial Hash"), STAT_ZoneProjectQuerySpatialHash, STATGROUP_ZoneProject);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Spatial Hash Entries"), STAT_ZoneProjectSpatialHashEntries, STATGROUP_ZoneProject);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Spatial Hash Cells"), STAT_ZoneProjectSpatialHashCells, STATGROUP_ZoneProject);
+
+void UZoneProjectSpatialHashSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SET_DWORD_STAT(STAT_ZoneProjectSpatialHashEntries, Entries.Num());
+	SET_DWORD_STAT(STAT_ZoneProjectSpatialHashCells, Cells.Num());
+
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectUpdateSpatialHash);
+
+	// Only entries that crossed a cell border touch the cell map
+
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		FZoneProjectSpatialEntry& Entry = *It;
+
+		const AActor* Actor = Entry.Actor.Get();
+
+		if (!Actor)
+		{
+			// Destroyed without unregistering
+
+			const int32 Index = It.GetIndex();
+
+			RemoveFromCell(Index);
+			EntryIndices.Remove(Entry.Key);
+			It.RemoveCurrent();
+			continue;
+		}
+
+		if (!Entry.bStatic) MoveEntry(It.GetIndex(), Actor->GetActorLocation());
+	}
+}
+
+TStatId UZoneProjectSpatialHashSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UZoneProjectSpatialHashSubsystem, STATGROUP_ZoneProject);
+}
+
+bool UZoneProjectSpatialHashSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer)) return false;
+
+	const UWorld* World = Outer->GetWorld();
+	return World && World->GetNetMode() != NM_Client;
+}
+
+bool UZoneProjectSpatialHashSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+FIntPoint UZoneProjectSpatialHashSubsystem::GetCellCoords(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+}
+
+uint64 UZoneProjectSpatialHashSubsystem::GetCellKey(const FIntPoint& Coords)
+{
+	return (static_cast<uint64>(static_cast<uint32>(Coords.X)) << 32) | static_cast<uint32>(Coords.Y);
+}
+
+void UZoneProjectSpatialHashSubsystem::MoveEntry(const int32 Index, const FVector& Location)
+{
+	FZoneProjectSpatialEntry& Entry = Entries[Index];
+	Entry.Location = Location;
+
+	const uint64 Cell = GetCellKey(GetCellCoords(Location));
+	if (Cell == Entry.Cell) return;
+
+	RemoveFromCell(Index);
+
+	Entry.Cell = Cell;
+	Cells.FindOrAdd(Cell).Add(Index);
+}
+
+void UZoneProjectSpatialHashSubsystem::RemoveFromCell(const int32 Index)
+{
+	const uint64 Cell = Entries[Index].Cell;
+
+	if (TArray<int32>* CellEntries = Cells.Find(Cell))
+	{
+		CellEntries->RemoveSwap(Index, EAllowShrinking::No);
+		if (CellEntries->Num() == 0) Cells.Remove(Cell);
+	}
+}
+
+void UZoneProjectSpatialHashSubsystem::RegisterActor(AActor* Actor, const ESpatialCategory Category, const float Radius, const bool bStatic)
+{
+	if (!Actor || EntryIndices.Contains(Actor)) return;
+
+	FZoneProjectSpatialEntry Entry;
+	Entry.Actor = Actor;
+	Entry.Key = Actor;
+	Entry.Location = Actor->GetActorLocation();
+	Entry.Radius = Radius;
+	Entry.Cell = GetCellKey(GetCellCoords(Entry.Location));
+	Entry.Category = Category;
+	Entry.bStatic = bStatic;
+
+	const int32 Index = Entries.Add(Entry);
+
+	EntryIndices.Add(Actor, Index);
+	Cells.FindOrAdd(Entry.Cell).Add(Index);
+}
+
+void UZoneProjectSpatialHashSubsystem::UnregisterActor(AActor* Actor)
+{
+	int32 Index;
+	if (!EntryIndices.RemoveAndCopyValue(Actor, Index)) return;
+
+	RemoveFromCell(Index);
+	Entries.RemoveAt(Index);
+}
+
+void UZoneProjectSpatialHashSubsystem::UpdateActor(AActor* Actor)
+{
+	if (const int32* Index = EntryIndices.Find(Actor))
+	{
+		MoveEntry(*Index, Actor->GetActorLocation());
+	}
+}
+
+void UZoneProjectSpatialHashSubsystem::ForEachInCells(const FIntPoint& Min, const FIntPoint& Max, const ESpatialCategory Categories,
+	TFunctionRef<void(const FZoneProjectSpatialEntry&)> Visitor) const
+{
+	const int64 NumQueryCells = static_cast<int64>(Max.X - Min.X + 1) * (Max.Y - Min.Y + 1);
+
+	auto VisitCell = [this, Categories, &Visitor](const TArray<int32>& CellEntries)
+	{
+		for (const int32 Index : CellEntries)
+		{
+			const FZoneProjectSpatialEntry& Entry = Entries[Index];
+			if (EnumHasAnyFlags(Entry.Category, Categories) && Entry.Actor.IsValid()) Visitor(Entry);
+		}
+	};
+
+	// A query larger than the populated area is cheaper to answer by walking the occupied cells
+
+	if (NumQueryCells > Cells.Num())
+	{
+		for (const TPair<uint64, TArray<int32>>& Pair : Cells)
+		{
+			const FIntPoint Coords(static_cast<int32>(Pair.Key >> 32), static_cast<int32>(Pair.Key & 0xFFFFFFFF));
+
+			if (Coords.X >= Min.X && Coords.X <= Max.X && Coords.Y >= Min.Y && Coords.Y <= Max.Y) VisitCell(Pair.Value);
+		}
+
+		return;
+	}
+
+	for (int32 X = Min.X; X <= Max.X; ++X)
+	{
+		for (int32 Y = Min.Y; Y <= Max.Y; ++Y)
+		{
+			if (const TArray<int32>* CellEntries = Cells.Find(GetCellKey(FIntPoint(X, Y)))) VisitCell(*CellEntries);
+		}
+	}
+}
+
+void UZoneProjectSpatialHashSubsystem::QueryRadius(const FVector& Center, const float Radius, const ESpatialCategory Categories,
+	TArray<AActor*>& OutActors) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectQuerySpatialHash);
+
+	OutActors.Reset();
+
+	const FVector Extent(Radius, Radius, 0.f);
+
+	ForEachInCells(GetCellCoords(Center - Extent), GetCellCoords(Center + Extent), Categories, [&](const FZoneProjectSpatialEntry& Entry)
+	{
+		if (FVector::DistSquared2D(Center, Entry.Location) <= FMath::Square(Radius + Entry.Radius)) OutActors.Add(Entry.Actor.Get());
+	});
+}
+
+void UZoneProjectSpatialHashSubsystem::QueryBox(const FBox2D& Box, const ESpatialCategory Categories, TArray<AActor*>& OutActors) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectQuerySpatialHash);
+
+	OutActors.Reset();
+
+	const FVector Min(Box.Min.X, Box.Min.Y, 0.f);
+	const FVector Max(Box.Max.X, Box.Max.Y, 0.f);
+
+	ForEachInCells(GetCellCoords(Min), GetCellCoords(Max), Categories, [&](const FZoneProjectSpatialEntry& Entry)
+	{
+		if (Box.ExpandBy(Entry.Radius).IsInside(FVector2D(Entry.Location))) OutActors.Add(Entry.Actor.Get());
+	});
+}
+
+void UZoneProjectSpatialHashSubsystem::QueryNearest(const FVector& Center, const int32 Count, const float MaxRadius,
+	const ESpatialCategory Categories, TArray<AActor*>& OutActors, TFunctionRef<bool(const AActor*)> Filter) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectQuerySpatialHash);
+
+	OutActors.Reset();
+
+	if (Count <= 0) return;
+
+	TArray<TPair<float, AActor*>, TInlineAllocator<16>> Candidates;
+
+	const FIntPoint CenterCell = GetCellCoords(Center);
+	const int32 MaxRing = FMath::CeilToInt32(MaxRadius / CellSize);
+
+	// Search rings of cells outwards until nothing in the next ring can be closer than the found candidates
+
+	for (int32 Ring = 0; Ring <= MaxRing; ++Ring)
+	{
+		for (int32 X = CenterCell.X - Ring; X <= CenterCell.X + Ring; ++X)
+		{
+			for (int32 Y = CenterCell.Y - Ring; Y <= CenterCell.Y + Ring; ++Y)
+			{
+				// Only the border of the ring, the inside was visited already
+
+				if (FMath::Abs(X - CenterCell.X) != Ring && FMath::Abs(Y - CenterCell.Y) != Ring) continue;
+
+				const TArray<int32>* CellEntries = Cells.Find(GetCellKey(FIntPoint(X, Y)));
+				if (!CellEntries) continue;
+
+				for (const int32 Index : *CellEntries)
+				{
+					const FZoneProjectSpatialEntry& Entry = Entries[Index];
+
+					AActor* Actor = Entry.Actor.Get();
+					if (!Actor || !EnumHasAnyFlags(Entry.Category, Categories) || !Filter(Actor)) continue;
+
+					const float Distance = FMath::Max(FVector::Dist2D(Center, Entry.Location) - Entry.Radius, 0.f);
+					if (Distance <= MaxRadius) Candidates.Emplace(Distance, Actor);
+				}
+			}
+		}
+
+		if (Candidates.Num() >= Count)
+		{
+			Candidates.Sort([](const TPair<float, AActor*>& A, const TPair<float, AActor*>& B) { return A.Key < B.Key; });
+			if (Candidates[Count - 1].Key <= Ring * CellSize) break;
+		}
+	}
+
+	Candidates.Sort([](const TPair<float, AActor*>& A, const TPair<float, AActor*>& B) { return A.Key < B.Key; });
+
+	for (int32 Index = 0; Index < FMath::Min(Count, Candidates.Num()); ++Index)
+	{
+		OutActors.Add(Candidates[Index].Value);
+	}
+}
+
+bool UZoneProjectSpatialHashSubsystem::AnyInRadius(const FVector& Center, const float Radius, const ESpatialCategory Categories) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectQuerySpatialHash);
+
+	bool bFound = false;
+
+	const FVector Extent(Radius, Radius, 0.f);
+
+	ForEachInCells(GetCellCoords(Center - Extent), GetCellCoords(Center + Extent), Categories, [&](const FZoneProjectSpatialEntry& Entry)
+	{
+		bFound |= FVector::DistSquared2D(Center, Entry.Location) <= FMath::Square(Radius + Entry.Radius);
+	});
+
+	return bFound;
+}
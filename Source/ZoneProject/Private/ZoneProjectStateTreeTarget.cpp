@@ -0,0 +1,51 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#include "ZoneProjectStateTreeTarget.h"
+#include "ZoneProjectTargetSubsystem.h"
+#include "StateTreeExecutionContext.h"
+
+void FZoneProjectTargetEvaluator::Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const
+{
+	FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+	InstanceData.Target = nullptr;
+	InstanceData.bHasTarget = false;
+	InstanceData.Distance = 0.f;
+	InstanceData.bHasLineOfSight = false;
+
+	UZoneProjectTargetSubsystem* Targets = Context.GetWorld() ? Context.GetWorld()->GetSubsystem<UZoneProjectTargetSubsystem>() : nullptr;
+	if (!Targets || !InstanceData.Actor) return;
+
+	const FZoneProjectTargetInfo Info = Targets->GetTargetInfo(InstanceData.Actor);
+
+	InstanceData.Target = Info.Target.Get();
+	InstanceData.bHasTarget = InstanceData.Target != nullptr;
+	InstanceData.Distance = Info.Distance;
+	InstanceData.bHasLineOfSight = Info.bHasLineOfSight;
+}
+
+void FZoneProjectTargetEvaluator::TreeStop(FStateTreeExecutionContext& Context) const
+{
+	const FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+	if (UZoneProjectTargetSubsystem* Targets = Context.GetWorld() ? Context.GetWorld()->GetSubsystem<UZoneProjectTargetSubsystem>() : nullptr)
+	{
+		Targets->UnregisterQuerier(InstanceData.Actor);
+	}
+}
+
+bool FZoneProjectTargetInRangeCondition::TestCondition(FStateTreeExecutionContext& Context) const
+{
+	const FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+	bool bResult = false;
+
+	if (UZoneProjectTargetSubsystem* Targets = Context.GetWorld() ? Context.GetWorld()->GetSubsystem<UZoneProjectTargetSubsystem>() : nullptr)
+	{
+		const FZoneProjectTargetInfo Info = Targets->GetTargetInfo(InstanceData.Actor);
+
+		bResult = Info.Target.IsValid() && Info.Distance <= InstanceData.MaxDistance && (!InstanceData.bRequireLineOfSight || Info.bHasLineOfSight);
+	}
+
+	return bResult ^ bInvert;
+}
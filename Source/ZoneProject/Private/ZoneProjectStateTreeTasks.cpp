@@ -0,0 +1,149 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#include "ZoneProjectStateTreeTasks.h"
+#include "ZoneProjectCharacter.h"
+#include "ZoneProjectTargetSubsystem.h"
+#include "AIController.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "StateTreeExecutionContext.h"
+
+namespace ZoneProjectStateTree
+{
+	/* Return the cached target of the pawn controlled by the controller */
+	static APawn* GetTarget(const FStateTreeExecutionContext& Context, const AAIController* AIController, FZoneProjectTargetInfo* OutInfo = nullptr)
+	{
+		APawn* Pawn = AIController ? AIController->GetPawn() : nullptr;
+		if (!Pawn) return nullptr;
+
+		UZoneProjectTargetSubsystem* Targets = Context.GetWorld() ? Context.GetWorld()->GetSubsystem<UZoneProjectTargetSubsystem>() : nullptr;
+		if (!Targets) return nullptr;
+
+		const FZoneProjectTargetInfo Info = Targets->GetTargetInfo(Pawn);
+		if (OutInfo) *OutInfo = Info;
+
+		return Info.Target.Get();
+	}
+}
+
+EStateTreeRunStatus FZoneProjectMoveToTargetTask::EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
+{
+	FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+	InstanceData.MoveTarget = nullptr;
+
+	return Tick(Context, 0.f);
+}
+
+EStateTreeRunStatus FZoneProjectMoveToTargetTask::Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const
+{
+	FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+	AAIController* AIController = InstanceData.AIController;
+
+	APawn* Target = ZoneProjectStateTree::GetTarget(Context, AIController);
+	if (!Target) return EStateTreeRunStatus::Failed;
+
+	if (FVector::Dist2D(AIController->GetPawn()->GetActorLocation(), Target->GetActorLocation()) <= InstanceData.AcceptanceRadius)
+	{
+		return EStateTreeRunStatus::Succeeded;
+	}
+
+	// Only request a new path when the target changed or the previous move ended
+
+	if (Target != InstanceData.MoveTarget || AIController->GetMoveStatus() == EPathFollowingStatus::Idle)
+	{
+		InstanceData.MoveTarget = Target;
+
+		const EPathFollowingRequestResult::Type Result = AIController->MoveToActor(Target, InstanceData.AcceptanceRadius);
+		if (Result == EPathFollowingRequestResult::Failed) return EStateTreeRunStatus::Failed;
+	}
+
+	return EStateTreeRunStatus::Running;
+}
+
+void FZoneProjectMoveToTargetTask::ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
+{
+	const FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+	if (InstanceData.AIController) InstanceData.AIController->StopMovement();
+}
+
+EStateTreeRunStatus FZoneProjectAttackTargetTask::EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
+{
+	const FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+	AAIController* AIController = InstanceData.AIController;
+
+	APawn* Target = ZoneProjectStateTree::GetTarget(Context, AIController);
+	if (!Target) return EStateTreeRunStatus::Failed;
+
+	AIController->SetFocus(Target);
+
+	if (AZoneProjectCharacter* Character = Cast<AZoneProjectCharacter>(AIController->GetPawn()))
+	{
+		Character->StartFire();
+	}
+
+	return Tick(Context, 0.f);
+}
+
+EStateTreeRunStatus FZoneProjectAttackTargetTask::Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const
+{
+	const FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+	FZoneProjectTargetInfo Info;
+
+	APawn* Target = ZoneProjectStateTree::GetTarget(Context, InstanceData.AIController, &Info);
+	if (!Target) return EStateTreeRunStatus::Failed;
+
+	// Leave the state to let the tree move closer or find a line of sight
+
+	if (Info.Distance > InstanceData.AttackRange) return EStateTreeRunStatus::Succeeded;
+	if (InstanceData.bRequireLineOfSight && !Info.bHasLineOfSight) return EStateTreeRunStatus::Succeeded;
+
+	if (InstanceData.AIController->GetFocusActor() != Target) InstanceData.AIController->SetFocus(Target);
+
+	return EStateTreeRunStatus::Running;
+}
+
+void FZoneProjectAttackTargetTask::ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
+{
+	const FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+	AAIController* AIController = InstanceData.AIController;
+	if (!AIController) return;
+
+	if (AZoneProjectCharacter* Character = Cast<AZoneProjectCharacter>(AIController->GetPawn()))
+	{
+		Character->StopFire();
+	}
+
+	AIController->ClearFocus(EAIFocusPriority::Gameplay);
+}
+
+EStateTreeRunStatus FZoneProjectTurnToTargetTask::EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
+{
+	const FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+	APawn* Target = ZoneProjectStateTree::GetTarget(Context, InstanceData.AIController);
+	if (!Target) return EStateTreeRunStatus::Failed;
+
+	InstanceData.AIController->SetFocus(Target);
+
+	return Tick(Context, 0.f);
+}
+
+EStateTreeRunStatus FZoneProjectTurnToTargetTask::Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const
+{
+	const FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+	const APawn* Target = ZoneProjectStateTree::GetTarget(Context, InstanceData.AIController);
+	if (!Target) return EStateTreeRunStatus::Failed;
+
+	const APawn* Pawn = InstanceData.AIController->GetPawn();
+
+	const FVector Direction = (Target->GetActorLocation() - Pawn->GetActorLocation()).GetSafeNormal2D();
+	const float CosAngle = FVector::DotProduct(Pawn->GetActorForwardVector().GetSafeNormal2D(), Direction);
+
+	return CosAngle >= FMath::Cos(FMath::DegreesToRadians(InstanceData.AcceptableAngle)) ? EStateTreeRunStatus::Succeeded : EStateTreeRunStatus::Running;
+}
@@ -0,0 +1,121 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#include "ZoneProjectTargetSubsystem.h"
+#include "ZoneProject/ZoneProject.h"
+#include "ZoneProjectCharacter.h"
+#include "ZoneProjectSpatialHashSubsystem.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Update Target Queries"), STAT_ZoneProjectUpdateTargetQueries, STATGROUP_ZoneProject);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Target Queriers"), STAT_ZoneProjectTargetQueriers, STATGROUP_ZoneProject);
+
+void UZoneProjectTargetSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SET_DWORD_STAT(STAT_ZoneProjectTargetQueriers, Results.Num());
+
+	if (Results.Num() == 0 || GetWorld()->GetNetMode() == NM_Client) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectUpdateTargetQueries);
+
+	// Update a fixed number of queriers per frame in a round robin, the rest keep their cached result
+
+	int32 Budget = FMath::Min(MaxQueriesPerFrame, Results.Num());
+
+	while (Budget-- > 0 && Results.Num() > 0)
+	{
+		if (Cursor >= Results.Num()) Cursor = 0;
+
+		if (!Results[Cursor].Querier.IsValid())
+		{
+			// Destroyed without unregistering, the swapped-in result is updated at the same cursor
+
+			ResultIndices.Remove(Results[Cursor].Key);
+			Results.RemoveAtSwap(Cursor, 1, EAllowShrinking::No);
+			if (Results.IsValidIndex(Cursor)) ResultIndices.Add(Results[Cursor].Key, Cursor);
+			continue;
+		}
+
+		UpdateResult(Results[Cursor]);
+		Cursor++;
+	}
+}
+
+TStatId UZoneProjectTargetSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UZoneProjectTargetSubsystem, STATGROUP_ZoneProject);
+}
+
+bool UZoneProjectTargetSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UZoneProjectTargetSubsystem::UpdateResult(FZoneProjectTargetInfo& Result) const
+{
+	const AActor* Querier = Result.Querier.Get();
+	const FVector Location = Querier->GetActorLocation();
+
+	// Only the cells around the querier are searched instead of every player
+
+	const UZoneProjectSpatialHashSubsystem* SpatialHash = GetWorld()->GetSubsystem<UZoneProjectSpatialHashSubsystem>();
+	if (!SpatialHash) return;
+
+	TArray<AActor*> Nearest;
+	SpatialHash->QueryNearest(Location, 1, MaxTargetDistance, ESpatialCategory::Character, Nearest, [](const AActor* Actor)
+	{
+		const AZoneProjectCharacter* Character = CastChecked<AZoneProjectCharacter>(Actor);
+		return Character->IsPlayerControlled() && Character->IsAlive();
+	});
+
+	APawn* Target = Nearest.Num() > 0 ? CastChecked<APawn>(Nearest[0]) : nullptr;
+
+	Result.Target = Target;
+	Result.Distance = Target ? FVector::Dist2D(Location, Target->GetActorLocation()) : 0.f;
+	Result.UpdateTime = GetWorld()->GetTimeSeconds();
+	Result.bHasLineOfSight = false;
+
+	if (Target)
+	{
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ZoneProjectTargetLineOfSight), false, Querier);
+		QueryParams.AddIgnoredActor(Target);
+
+		Result.bHasLineOfSight = !GetWorld()->LineTraceTestByChannel(Location, Target->GetActorLocation(), LineOfSightChannel, QueryParams);
+	}
+}
+
+FZoneProjectTargetInfo UZoneProjectTargetSubsystem::GetTargetInfo(AActor* Querier)
+{
+	if (!Querier) return FZoneProjectTargetInfo();
+
+	if (const int32* Index = ResultIndices.Find(Querier))
+	{
+		return Results[*Index];
+	}
+
+	// Register the new querier with an immediate result so it doesn't start without a target
+
+	FZoneProjectTargetInfo& Result = Results.AddDefaulted_GetRef();
+	Result.Querier = Querier;
+	Result.Key = Querier;
+
+	ResultIndices.Add(Querier, Results.Num() - 1);
+
+	UpdateResult(Result);
+
+	return Result;
+}
+
+void UZoneProjectTargetSubsystem::UnregisterQuerier(AActor* Querier)
+{
+	int32 Index;
+	if (!ResultIndices.RemoveAndCopyValue(Querier, Index)) return;
+
+	Results.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+
+	if (Results.IsValidIndex(Index))
+	{
+		ResultIndices.Add(Results[Index].Key, Index);
+	}
+}
@@ -0,0 +1,402 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#include "ZoneProjectWaveDirectorSubsystem.h"
+#include "ZoneProject/ZoneProject.h"
+#include "ZoneProjectCharacter.h"
+#include "ZoneProjectCrowdSubsystem.h"
+#include "ZoneProjectSpatialHashSubsystem.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "NavigationData.h"
+#include "NavigationSystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Direct Waves"), STAT_ZoneProjectDirectWaves, STATGROUP_ZoneProject);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pending Spawns"), STAT_ZoneProjectPendingSpawns, STATGROUP_ZoneProject);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Cached Spawn Points"), STAT_ZoneProjectCachedSpawnPoints, STATGROUP_ZoneProject);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Spawn Queries In Flight"), STAT_ZoneProjectSpawnQueries, STATGROUP_ZoneProject);
+
+static FAutoConsoleCommandWithWorld GWaveStatsCommand(
+	TEXT("ZoneProject.Enemies.WaveStats"),
+	TEXT("Print the pending enemies and the cached spawn points of the wave director in the current world"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UZoneProjectWaveDirectorSubsystem* Subsystem = World ? World->GetSubsystem<UZoneProjectWaveDirectorSubsystem>() : nullptr)
+		{
+			Subsystem->DumpStats();
+		}
+	}));
+
+void UZoneProjectWaveDirectorSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (UNavigationSystemV1* NavigationSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(&InWorld))
+	{
+		NavigationSystem->OnNavigationGenerationFinishedDelegate.AddDynamic(this, &UZoneProjectWaveDirectorSubsystem::OnNavigationGenerated);
+	}
+}
+
+void UZoneProjectWaveDirectorSubsystem::Deinitialize()
+{
+	if (UNavigationSystemV1* NavigationSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+	{
+		for (const TPair<uint32, uint32>& Query : QueriesInFlight) NavigationSystem->AbortAsyncFindPathRequest(Query.Key);
+	}
+
+	QueriesInFlight.Empty();
+	RegionPoints.Empty();
+	PendingSpawns.Empty();
+
+	Super::Deinitialize();
+}
+
+void UZoneProjectWaveDirectorSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (GetWorld()->GetNetMode() == NM_Client) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_ZoneProjectDirectWaves);
+
+	Players.Reset();
+
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController* PlayerController = Iterator->Get();
+		APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+
+		if (Pawn) Players.Add(Pawn);
+	}
+
+	if (Players.Num() > 0 && SpawnDistance > 0.f)
+	{
+		SpawnPending();
+		QueryPoints();
+	}
+
+	SET_DWORD_STAT(STAT_ZoneProjectPendingSpawns, PendingSpawns.Num());
+	SET_DWORD_STAT(STAT_ZoneProjectCachedSpawnPoints, GetNumPoints());
+	SET_DWORD_STAT(STAT_ZoneProjectSpawnQueries, QueriesInFlight.Num());
+}
+
+TStatId UZoneProjectWaveDirectorSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UZoneProjectWaveDirectorSubsystem, STATGROUP_ZoneProject);
+}
+
+bool UZoneProjectWaveDirectorSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UZoneProjectWaveDirectorSubsystem::QueueWave(TSubclassOf<AZoneProjectCharacter> EnemyClass, int32 CountPerPlayer, float Distance, float Clearance)
+{
+	if (!EnemyClass || GetWorld()->GetNetMode() == NM_Client) return;
+
+	// The cached points were validated for the previous distance
+
+	if (!FMath::IsNearlyEqual(Distance, SpawnDistance)) RegionPoints.Reset();
+
+	SpawnDistance = Distance;
+	SpawnClearance = Clearance;
+
+	// Interleave the players so every one of them gets enemies from the first frames of the wave
+
+	TArray<APawn*> WavePlayers;
+
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController* PlayerController = Iterator->Get();
+		APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+
+		if (Pawn) WavePlayers.Add(Pawn);
+	}
+
+	for (int32 Count = 0; Count < CountPerPlayer; ++Count)
+	{
+		for (APawn* Player : WavePlayers)
+		{
+			if (PendingSpawns.Num() >= MaxPendingSpawns) return;
+
+			FZoneProjectPendingSpawn& Pending = PendingSpawns.AddDefaulted_GetRef();
+			Pending.EnemyClass = EnemyClass;
+			Pending.Player = Player;
+		}
+	}
+}
+
+void UZoneProjectWaveDirectorSubsystem::SpawnPending()
+{
+	UZoneProjectCrowdSubsystem* Crowd = GetWorld()->GetSubsystem<UZoneProjectCrowdSubsystem>();
+	if (!Crowd || PendingSpawns.IsEmpty()) return;
+
+	const UZoneProjectSpatialHashSubsystem* SpatialHash = GetWorld()->GetSubsystem<UZoneProjectSpatialHashSubsystem>();
+	const UNavigationSystemV1* NavigationSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const bool bHasNavigation = NavigationSystem && NavigationSystem->GetDefaultNavDataInstance();
+
+	const double Time = GetWorld()->GetTimeSeconds();
+
+	int32 Index = NextSpawn < PendingSpawns.Num() ? NextSpawn : 0;
+	int32 Spawned = 0;
+
+	for (int32 Attempt = 0; Attempt < MaxSpawnAttemptsPerFrame && Spawned < MaxSpawnsPerFrame && PendingSpawns.Num() > 0; ++Attempt)
+	{
+		if (Index >= PendingSpawns.Num()) Index = 0;
+
+		FZoneProjectPendingSpawn& Pending = PendingSpawns[Index];
+
+		// Enemies of a player who left go to another one
+
+		if (!Pending.Player.IsValid()) Pending.Player = Players[FMath::RandHelper(Players.Num())];
+
+		const FVector PlayerLocation = Pending.Player->GetActorLocation();
+
+		FVector Location;
+
+		if (bHasNavigation)
+		{
+			FZoneProjectSpawnPoint* Point = FindPoint(PlayerLocation);
+
+			if (!Point)
+			{
+				++Index;
+				continue;
+			}
+
+			Point->LastSpawnTime = Time;
+
+			const float HalfHeight = GetDefault<AZoneProjectCharacter>(Pending.EnemyClass)->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+			Location = Point->Location + FVector(0.f, 0.f, HalfHeight);
+		}
+		else
+		{
+			// Without a navmesh spawn at a random point of the ring at the player height
+
+			const float Angle = FMath::FRandRange(0.f, UE_TWO_PI);
+			Location = PlayerLocation + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * SpawnDistance;
+
+			if (SpatialHash && SpatialHash->AnyInRadius(Location, SpawnClearance, ESpatialCategory::Character))
+			{
+				++Index;
+				continue;
+			}
+		}
+
+		// Spawn the enemy facing its player, enemies far from every player start as lightweight crowd entities
+
+		const FRotator Rotation = (PlayerLocation - Location).GetSafeNormal2D().Rotation();
+		Crowd->SpawnEnemy(Pending.EnemyClass, FTransform(Rotation, Location));
+
+		PendingSpawns.RemoveAt(Index, 1, EAllowShrinking::No);
+
+		++Spawned;
+		++NumSpawned;
+	}
+
+	NextSpawn = Index;
+}
+
+void UZoneProjectWaveDirectorSubsystem::QueryPoints()
+{
+	UNavigationSystemV1* NavigationSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const ANavigationData* NavigationData = NavigationSystem ? NavigationSystem->GetDefaultNavDataInstance() : nullptr;
+
+	if (!NavigationData) return;
+
+	if (NextQueryPlayer >= Players.Num()) NextQueryPlayer = 0;
+
+	// Players are visited in turn, the loop ends once all of them in a row have enough points
+
+	int32 Attempts = 0;
+	int32 Satisfied = 0;
+
+	while (Attempts < MaxQueriesPerFrame && QueriesInFlight.Num() < MaxQueriesInFlight && Satisfied < Players.Num())
+	{
+		const FVector PlayerLocation = Players[NextQueryPlayer]->GetActorLocation();
+		NextQueryPlayer = (NextQueryPlayer + 1) % Players.Num();
+
+		if (CountPoints(PlayerLocation) >= MinPointsPerPlayer)
+		{
+			++Satisfied;
+			continue;
+		}
+
+		Satisfied = 0;
+		++Attempts;
+
+		const float Angle = FMath::FRandRange(0.f, UE_TWO_PI);
+		const float Distance = SpawnDistance + FMath::FRandRange(-0.5f, 0.5f) * DistanceTolerance;
+
+		const FVector Candidate = PlayerLocation + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * Distance;
+
+		const TArray<FZoneProjectSpawnPoint>* Points = RegionPoints.Find(GetRegion(Candidate));
+		if (Points && Points->Num() >= MaxPointsPerRegion) continue;
+
+		// The path runs from the candidate to the player, so a valid point is both on the navmesh and able to reach the player
+
+		const FPathFindingQuery Query(this, *NavigationData, Candidate, PlayerLocation);
+
+		const uint32 QueryId = NavigationSystem->FindPathAsync(NavigationData->GetConfig(), Query,
+			FNavPathQueryDelegate::CreateUObject(this, &UZoneProjectWaveDirectorSubsystem::OnPathQueryFinished));
+
+		if (QueryId != INVALID_NAVQUERYID) QueriesInFlight.Add(QueryId, NavGeneration);
+	}
+}
+
+void UZoneProjectWaveDirectorSubsystem::OnPathQueryFinished(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path)
+{
+	uint32 Generation;
+	if (!QueriesInFlight.RemoveAndCopyValue(QueryId, Generation)) return;
+
+	if (Result != ENavigationQueryResult::Success || !Path.IsValid() || Path->IsPartial() || Path->GetPathPoints().IsEmpty())
+	{
+		++NumFailedQueries;
+		return;
+	}
+
+	// The path starts at the candidate projected onto the navmesh
+
+	const FVector Location = Path->GetPathPoints()[0].Location;
+
+	TArray<FZoneProjectSpawnPoint>& Points = RegionPoints.FindOrAdd(GetRegion(Location));
+	if (Points.Num() >= MaxPointsPerRegion) return;
+
+	for (const FZoneProjectSpawnPoint& Point : Points)
+	{
+		if (FVector::DistSquared2D(Point.Location, Location) < FMath::Square(SpawnClearance)) return;
+	}
+
+	// A path found on the previous navmesh is validated again before the point is used
+
+	FZoneProjectSpawnPoint& Point = Points.AddDefaulted_GetRef();
+	Point.Location = Location;
+	Point.NavGeneration = Generation;
+}
+
+void UZoneProjectWaveDirectorSubsystem::OnNavigationGenerated(ANavigationData* NavigationData)
+{
+	// Dynamic generation rebuilds tiles around the invokers all the time, most points are still valid afterwards
+
+	++NavGeneration;
+}
+
+FIntPoint UZoneProjectWaveDirectorSubsystem::GetRegion(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt32(Location.X / RegionSize), FMath::FloorToInt32(Location.Y / RegionSize));
+}
+
+int32 UZoneProjectWaveDirectorSubsystem::CountPoints(const FVector& PlayerLocation) const
+{
+	const float Radius = SpawnDistance + DistanceTolerance;
+
+	const FIntPoint Min = GetRegion(PlayerLocation - FVector(Radius));
+	const FIntPoint Max = GetRegion(PlayerLocation + FVector(Radius));
+
+	int32 Count = 0;
+
+	for (int32 X = Min.X; X <= Max.X; ++X)
+	{
+		for (int32 Y = Min.Y; Y <= Max.Y; ++Y)
+		{
+			const TArray<FZoneProjectSpawnPoint>* Points = RegionPoints.Find(FIntPoint(X, Y));
+			if (!Points) continue;
+
+			for (const FZoneProjectSpawnPoint& Point : *Points)
+			{
+				if (FMath::Abs(FVector::Dist2D(Point.Location, PlayerLocation) - SpawnDistance) <= DistanceTolerance) ++Count;
+			}
+		}
+	}
+
+	return Count;
+}
+
+FZoneProjectSpawnPoint* UZoneProjectWaveDirectorSubsystem::FindPoint(const FVector& PlayerLocation)
+{
+	const UZoneProjectSpatialHashSubsystem* SpatialHash = GetWorld()->GetSubsystem<UZoneProjectSpatialHashSubsystem>();
+
+	const float Radius = SpawnDistance + DistanceTolerance;
+	const double Time = GetWorld()->GetTimeSeconds();
+
+	const FIntPoint Min = GetRegion(PlayerLocation - FVector(Radius));
+	const FIntPoint Max = GetRegion(PlayerLocation + FVector(Radius));
+
+	// Pick uniformly among the usable points without collecting them (reservoir sampling)
+
+	TArray<FZoneProjectSpawnPoint>* ResultPoints = nullptr;
+	int32 ResultIndex = INDEX_NONE;
+	int32 NumCandidates = 0;
+
+	for (int32 X = Min.X; X <= Max.X; ++X)
+	{
+		for (int32 Y = Min.Y; Y <= Max.Y; ++Y)
+		{
+			TArray<FZoneProjectSpawnPoint>* Points = RegionPoints.Find(FIntPoint(X, Y));
+			if (!Points) continue;
+
+			for (int32 Index = 0; Index < Points->Num(); ++Index)
+			{
+				const FZoneProjectSpawnPoint& Point = (*Points)[Index];
+
+				if (Time - Point.LastSpawnTime < PointCooldown) continue;
+				if (FMath::Abs(FVector::Dist2D(Point.Location, PlayerLocation) - SpawnDistance) > DistanceTolerance) continue;
+				if (SpatialHash && SpatialHash->AnyInRadius(Point.Location, SpawnClearance, ESpatialCategory::Character)) continue;
+
+				if (FMath::RandHelper(++NumCandidates) == 0)
+				{
+					ResultPoints = Points;
+					ResultIndex = Index;
+				}
+			}
+		}
+	}
+
+	if (!ResultPoints) return nullptr;
+
+	FZoneProjectSpawnPoint& Result = (*ResultPoints)[ResultIndex];
+
+	// Only the picked point is validated against the rebuilt navmesh, a single projection instead of a new path query
+
+	if (Result.NavGeneration != NavGeneration)
+	{
+		const UNavigationSystemV1* NavigationSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+
+		FNavLocation Projected;
+
+		if (!NavigationSystem || !NavigationSystem->ProjectPointToNavigation(Result.Location, Projected))
+		{
+			ResultPoints->RemoveAtSwap(ResultIndex, 1, EAllowShrinking::No);
+			return nullptr;
+		}
+
+		Result.Location = Projected.Location;
+		Result.NavGeneration = NavGeneration;
+	}
+
+	return &Result;
+}
+
+int32 UZoneProjectWaveDirectorSubsystem::GetNumPoints() const
+{
+	int32 Count = 0;
+	for (const TPair<FIntPoint, TArray<FZoneProjectSpawnPoint>>& Pair : RegionPoints) Count += Pair.Value.Num();
+
+	return Count;
+}
+
+void UZoneProjectWaveDirectorSubsystem::DumpStats() const
+{
+	UE_LOG(LogZoneProject, Log, TEXT("Wave director in %s: %d pending enemies, %d spawned, spawn distance %.0f"),
+		*GetWorld()->GetMapName(), PendingSpawns.Num(), NumSpawned, SpawnDistance);
+
+	UE_LOG(LogZoneProject, Log, TEXT("  %d cached points in %d regions, %d queries in flight, %d failed"),
+		GetNumPoints(), RegionPoints.Num(), QueriesInFlight.Num(), NumFailedQueries);
+
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController* PlayerController = Iterator->Get();
+		const APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+
+		if (Pawn) UE_LOG(LogZoneProject, Log, TEXT("  %s: %d points"), *Pawn->GetName(), CountPoints(Pawn->GetActorLocation()));
+	}
+}
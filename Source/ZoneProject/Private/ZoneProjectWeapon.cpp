@@ -2,13 +2,31 @@
 
 #include "ZoneProjectWeapon.h"
 #include "ZoneProjectCharacter.h"
+#include "ZoneProjectController.h"
+#include "ZoneProjectLagCompensationSubsystem.h"
+#include "ZoneProjectNetTelemetrySubsystem.h"
+#include "ZoneProjectProjectile.h"
+#include "ZoneProjectProjectileManager.h"
+#include "ZoneProjectProjectileSubsystem.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+
+const FPrimaryAssetType AZoneProjectWeapon::PrimaryAssetType = TEXT("Weapon");
 
 AZoneProjectWeapon::AZoneProjectWeapon()
 {
+	// Tick only while the fire scheduler has shots to fire
+
 	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
 
 	bReplicates = true;
 
+	// The fire state only changes when the trigger is pulled or released, the channel is woken up for it
+
+	NetDormancy = DORM_DormantAll;
+
 	// Set up the mesh component
 
 	Mesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("Mesh"));
@@ -18,6 +36,13 @@ AZoneProjectWeapon::AZoneProjectWeapon()
 void AZoneProjectWeapon::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	// The owner predicts its own shots
+	Params.Condition = COND_SkipOwner;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AZoneProjectWeapon, FireState, Params);
 }
 
 void AZoneProjectWeapon::PreInitializeComponents()
@@ -36,14 +61,31 @@ void AZoneProjectWeapon::PostInitializeComponents()
 	Super::PostInitializeComponents();
 }
 
+FPrimaryAssetId AZoneProjectWeapon::GetPrimaryAssetId() const
+{
+	return GetBlueprintPrimaryAssetId(this, PrimaryAssetType);
+}
+
 void AZoneProjectWeapon::BeginPlay()
 {
 	Super::BeginPlay();
+
+	// Pre-allocate projectiles so the first shots don't spawn actors
+
+	if (bUseProjectileManager) return;
+
+	if (UZoneProjectProjectileSubsystem* Subsystem = GetWorld()->GetSubsystem<UZoneProjectProjectileSubsystem>())
+	{
+		Subsystem->WarmUp(ProjectileClass);
+		if (HasAuthority()) Subsystem->WarmUp(DamageProjectileClass);
+	}
 }
 
 void AZoneProjectWeapon::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
+
+	UpdateFireSchedule();
 }
 
 void AZoneProjectWeapon::OnRep_Instigator()
@@ -54,17 +96,263 @@ void AZoneProjectWeapon::OnRep_Instigator()
 	if (Character) AddTickPrerequisiteActor(Character);
 }
 
-void AZoneProjectWeapon::ReplicateFire(const FRotator Rotation)
+void AZoneProjectWeapon::StartFire()
+{
+	if (!Character || bTriggerHeld) return;
+
+	SetFiring(true);
+	BeginBurst(0.f);
+}
+
+void AZoneProjectWeapon::StopFire()
+{
+	SetFiring(false);
+	EndBurst();
+}
+
+void AZoneProjectWeapon::SetFiring(const bool bFiring)
+{
+	if (!Character || FireState.bFiring == bFiring) return;
+
+	FWeaponFireState NewFireState;
+
+	NewFireState.bFiring = bFiring;
+	NewFireState.BurstId = FireState.BurstId + (bFiring ? 1 : 0);
+	NewFireState.StartTime = AZoneProjectController::GetSynchronizedTime(this);
+	NewFireState.Seed = FMath::RandHelper(MAX_uint16 + 1);
+	NewFireState.AimYaw = FRotator::CompressAxisToShort(Character->GetBaseAimRotation().Yaw);
+
+	FireState = NewFireState;
+
+	if (HasAuthority())
+	{
+		MarkFireStateDirty();
+	}
+	else if (Character->IsLocallyControlled())
+	{
+		ServerSetFireState(NewFireState);
+	}
+}
+
+void AZoneProjectWeapon::ServerSetFireState_Implementation(const FWeaponFireState& NewFireState)
+{
+	UZoneProjectNetTelemetrySubsystem::RecordRpc(this, TEXT("ServerSetFireState"));
+
+	if (FireState.bFiring == NewFireState.bFiring) return;
+
+	// Never trust the client clock beyond the current server time, nor further back than hits can be rewound
+
+	const float ServerTime = GetWorld()->GetTimeSeconds();
+
+	const UZoneProjectLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UZoneProjectLagCompensationSubsystem>();
+	const float MaxLatency = LagCompensation ? LagCompensation->MaxRewindTime : 0.f;
+
+	FireState = NewFireState;
+	FireState.StartTime = FMath::Clamp(NewFireState.StartTime, ServerTime - MaxLatency, ServerTime);
+
+	MarkFireStateDirty();
+
+	// Run the authoritative schedule for the remote player from the moment the client pulled the trigger
+
+	if (FireState.bFiring) BeginBurst(ServerTime - FireState.StartTime); else EndBurst();
+}
+
+void AZoneProjectWeapon::MarkFireStateDirty()
+{
+	MARK_PROPERTY_DIRTY_FROM_NAME(AZoneProjectWeapon, FireState, this);
+	FlushNetDormancy();
+}
+
+void AZoneProjectWeapon::OnRep_FireState()
+{
+	if (!Character || Character->GetLocalRole() != ROLE_SimulatedProxy) return;
+
+	if (FireState.bFiring)
+	{
+		BeginBurst(FMath::Max(AZoneProjectController::GetSynchronizedTime(this) - FireState.StartTime, 0.f));
+	}
+	else
+	{
+		EndBurst();
+	}
+}
+
+void AZoneProjectWeapon::BeginBurst(const float Elapsed)
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	bTriggerHeld = true;
+	ShotIndex = 0;
+
+	switch (FireMode)
+	{
+		case EWeaponFireMode::Auto:  ShotsRemaining = INDEX_NONE; break;
+		case EWeaponFireMode::Burst: ShotsRemaining = BurstCount; break;
+		case EWeaponFireMode::Semi:  ShotsRemaining = 1; break;
+	}
+
+	// Respect the cooldown of the previous burst. Shots that were due before the burst became known here are fired
+	// right away by the schedule
+
+	NextShotTime = FMath::Max(Now - Elapsed, NextShotTime);
+
+	// Don't replay shots whose projectiles would already have expired
+
+	if (const TSubclassOf<AZoneProjectProjectile> Class = GetProjectileClass())
+	{
+		const float LifeTime = GetDefault<AZoneProjectProjectile>(Class)->LifeTime;
+		const int32 ExpiredShots = FMath::Max(FMath::FloorToInt((Now - NextShotTime - LifeTime) / FireRate) + 1, 0);
+
+		NextShotTime += ExpiredShots * FireRate;
+		ShotIndex = ExpiredShots;
+		if (ShotsRemaining != INDEX_NONE) ShotsRemaining = FMath::Max(ShotsRemaining - ExpiredShots, 0);
+	}
+
+	// Replay a limited number of overdue shots in one frame, the oldest ones are skipped
+
+	const int32 OverdueShots = NextShotTime <= Now ? FMath::FloorToInt((Now - NextShotTime) / FireRate) + 1 : 0;
+	const int32 SkippedShots = FMath::Max(OverdueShots - MaxReplayedShots, 0);
+
+	NextShotTime += SkippedShots * FireRate;
+	ShotIndex += SkippedShots;
+	if (ShotsRemaining != INDEX_NONE) ShotsRemaining = FMath::Max(ShotsRemaining - SkippedShots, 0);
+
+	SetActorTickEnabled(true);
+	UpdateFireSchedule();
+}
+
+void AZoneProjectWeapon::EndBurst()
 {
-	if (Character)
+	bTriggerHeld = false;
+
+	// Bursts always finish once started
+
+	if (FireMode != EWeaponFireMode::Burst) ShotsRemaining = 0;
+}
+
+void AZoneProjectWeapon::UpdateFireSchedule()
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	// Fire every shot that became due during the frame, so low frame rates don't lose shots
+
+	while (ShotsRemaining != 0 && NextShotTime <= Now)
 	{
-		if (Character->GetLocalRole() == ROLE_AutonomousProxy)
+		if (!Character || !Character->IsAlive())
 		{
-			Character->ServerFire();
+			ShotsRemaining = 0;
+			break;
 		}
-		else if (Character->GetLocalRole() == ROLE_Authority)
+
+		FireShot(static_cast<float>(Now - NextShotTime));
+
+		NextShotTime += FireRate;
+		if (ShotsRemaining != INDEX_NONE) ShotsRemaining--;
+	}
+
+	if (ShotsRemaining == 0) SetActorTickEnabled(false);
+}
+
+void AZoneProjectWeapon::FireShot(const float LateBy)
+{
+	const FRotator Rotation = GetShotRotation(ShotIndex++);
+
+	LaunchProjectile(Rotation, LateBy);
+
+	if (GetNetMode() != NM_DedicatedServer) SimulateFire(Rotation);
+}
+
+FRotator AZoneProjectWeapon::GetShotRotation(const int32 Index) const
+{
+	FRotator Rotation = Character->GetBaseAimRotation();
+
+	// Simulated proxies use the burst yaw for the first shot until the replicated movement catches up
+
+	if (Index == 0 && Character->GetLocalRole() == ROLE_SimulatedProxy)
+	{
+		Rotation.Yaw = FRotator::DecompressAxisFromShort(FireState.AimYaw);
+	}
+
+	// The burst seed makes the spread identical on every machine
+
+	if (SpreadAngle > 0.f)
+	{
+		const FRandomStream Stream(FireState.Seed + Index);
+		Rotation = Stream.VRandCone(Rotation.Vector(), FMath::DegreesToRadians(SpreadAngle)).Rotation();
+	}
+
+	return Rotation;
+}
+
+TSubclassOf<AZoneProjectProjectile> AZoneProjectWeapon::GetProjectileClass() const
+{
+	// With lag compensation the server doesn't deal damage for remote players, their clients report hits instead
+
+	const bool bClientAuthoritativeHits = bUseLagCompensation && Character && !Character->IsLocallyControlled();
+
+	return HasAuthority() && DamageProjectileClass && !bClientAuthoritativeHits ? DamageProjectileClass : ProjectileClass;
+}
+
+float AZoneProjectWeapon::GetProjectileDamage() const
+{
+	const TSubclassOf<AZoneProjectProjectile> Class = DamageProjectileClass ? DamageProjectileClass : ProjectileClass;
+	return Class ? GetDefault<AZoneProjectProjectile>(Class)->Damage : 0.f;
+}
+
+float AZoneProjectWeapon::GetProjectileRange() const
+{
+	const TSubclassOf<AZoneProjectProjectile> Class = DamageProjectileClass ? DamageProjectileClass : ProjectileClass;
+	if (!Class) return 0.f;
+
+	const AZoneProjectProjectile* Defaults = GetDefault<AZoneProjectProjectile>(Class);
+	return Defaults->GetMovement()->InitialSpeed * Defaults->LifeTime;
+}
+
+void AZoneProjectWeapon::ReportHit(AActor* HitActor, const FVector& Origin, const FVector& Direction) const
+{
+	if (!bUseLagCompensation || HasAuthority() || !Character || !Character->IsLocallyControlled()) return;
+
+	if (AZoneProjectCharacter* Target = Cast<AZoneProjectCharacter>(HitActor))
+	{
+		Character->ReportHit(Target, Origin, Direction);
+	}
+}
+
+AZoneProjectProjectile* AZoneProjectWeapon::SpawnProjectile(const FRotator Rotation)
+{
+	return LaunchProjectile(Rotation, 0.f);
+}
+
+AZoneProjectProjectile* AZoneProjectWeapon::LaunchProjectile(const FRotator Rotation, const float LateBy)
+{
+	const TSubclassOf<AZoneProjectProjectile> Class = GetProjectileClass();
+	if (!Class) return nullptr;
+
+	const AZoneProjectProjectile* Defaults = GetDefault<AZoneProjectProjectile>(Class);
+	const FVector Velocity = Rotation.Vector() * Defaults->GetMovement()->InitialSpeed;
+
+	// Move late shots forward along their path so shots fired in the same frame don't stack up. The jump is not swept,
+	// so it is kept within the distance between two shots
+
+	const float Advance = FMath::Min(LateBy, FireRate);
+
+	FVector Location = Mesh->DoesSocketExist(MuzzleSocketName) ? Mesh->GetSocketLocation(MuzzleSocketName) : GetActorLocation();
+	Location += Velocity * Advance;
+
+	if (bUseProjectileManager)
+	{
+		// The projectile class only provides the ballistic and damage settings
+
+		if (UZoneProjectProjectileManager* Manager = GetWorld()->GetSubsystem<UZoneProjectProjectileManager>())
 		{
-			Character->MulticastFire(Rotation);
+			Manager->LaunchProjectile(Location, Velocity, Defaults->LifeTime - Advance, Defaults->Damage, Character, Defaults->bDealDamage);
 		}
+
+		return nullptr;
 	}
+
+	UZoneProjectProjectileSubsystem* Subsystem = GetWorld()->GetSubsystem<UZoneProjectProjectileSubsystem>();
+	if (!Subsystem) return nullptr;
+
+	return Subsystem->AcquireProjectile(Class, FTransform(Rotation, Location), this, Character);
 }
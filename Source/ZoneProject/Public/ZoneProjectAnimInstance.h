@@ -0,0 +1,85 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimInstance.h"
+#include "ZoneProjectAnimInstance.generated.h"
+
+class AZoneProjectCharacter;
+class UCharacterMovementComponent;
+
+/**
+ * Anim Instance class. Base of the mannequin anim blueprints. Copies the character state once on the game thread
+ * and derives the locomotion and aim values in the thread-safe update, so the graphs can run on worker threads
+ */
+UCLASS(Transient, Blueprintable)
+class ZONEPROJECT_API UZoneProjectAnimInstance : public UAnimInstance
+{
+	GENERATED_BODY()
+
+protected:
+
+	/* Called when the anim instance is initialized */
+	virtual void NativeInitializeAnimation() override;
+
+	/* Called on the game thread before the update, only copies the character state */
+	virtual void NativeUpdateAnimation(float DeltaSeconds) override;
+
+	/* Called on a worker thread, derives the values used by the graph */
+	virtual void NativeThreadSafeUpdateAnimation(float DeltaSeconds) override;
+
+	/* Owning character */
+	UPROPERTY(Transient)
+	TObjectPtr<AZoneProjectCharacter> Character = nullptr;
+
+	/* Movement component of the owning character */
+	UPROPERTY(Transient)
+	TObjectPtr<UCharacterMovementComponent> Movement = nullptr;
+
+	/* Character state copied on the game thread */
+
+	FVector Velocity = FVector::ZeroVector;
+
+	FRotator ActorRotation = FRotator::ZeroRotator;
+
+	FRotator AimRotation = FRotator::ZeroRotator;
+
+public:
+
+	/* Indicates whether the character is alive */
+	UPROPERTY(Category = "Character", BlueprintReadOnly, Transient)
+	bool bIsAlive = true;
+
+	/* Indicates whether the character is sprinting */
+	UPROPERTY(Category = "Character", BlueprintReadOnly, Transient)
+	bool bIsSprinting = false;
+
+	/* Indicates whether the character is in the air */
+	UPROPERTY(Category = "Character", BlueprintReadOnly, Transient)
+	bool bIsFalling = false;
+
+	/* Indicates whether the character is moving on the ground */
+	UPROPERTY(Category = "Character", BlueprintReadOnly, Transient)
+	bool bShouldMove = false;
+
+	/* Horizontal speed */
+	UPROPERTY(Category = "Character", BlueprintReadOnly, Transient)
+	float GroundSpeed = 0.f;
+
+	/* Angle between the velocity and the facing direction in degrees */
+	UPROPERTY(Category = "Character", BlueprintReadOnly, Transient)
+	float Direction = 0.f;
+
+	/* Aim pitch relative to the character in degrees */
+	UPROPERTY(Category = "Character", BlueprintReadOnly, Transient)
+	float AimPitch = 0.f;
+
+	/* Aim yaw relative to the character in degrees */
+	UPROPERTY(Category = "Character", BlueprintReadOnly, Transient)
+	float AimYaw = 0.f;
+
+	/* Speed below which the character is considered standing */
+	UPROPERTY(Category = "Character", BlueprintReadOnly, EditDefaultsOnly)
+	float MinMoveSpeed = 3.f;
+};
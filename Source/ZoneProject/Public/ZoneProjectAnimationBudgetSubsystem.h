@@ -0,0 +1,92 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZoneProjectTypes.h"
+#include "AnimationBudgetAllocatorParameters.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ZoneProjectAnimationBudgetSubsystem.generated.h"
+
+class ACharacter;
+class UAnimationSharingSetup;
+struct FAnimUpdateRateParameters;
+
+/**
+ * Animation Budget Subsystem class. Caps the animation cost of enemies: their meshes tick under a fixed game thread budget,
+ * fall back to screen size based update rate optimization when the budget is disabled,
+ * and share the poses of a few leaders per locomotion state once they are distant or off-screen
+ */
+UCLASS(Config = Game)
+class ZONEPROJECT_API UZoneProjectAnimationBudgetSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Called when the world begins play */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+protected:
+
+	/* Only game worlds budget animations */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+public:
+
+	/* Tick enemy meshes through the animation budget allocator */
+	UPROPERTY(Config)
+	bool bUseBudgetAllocator = true;
+
+	/* Parameters of the animation budget allocator, including the game thread budget in milliseconds */
+	UPROPERTY(Config)
+	FAnimationBudgetAllocatorParameters BudgetParameters;
+
+	/* Screen size thresholds below which the update rate optimization skips one more frame */
+	UPROPERTY(Config)
+	TArray<float> UpdateRateScreenSizeThresholds;
+
+	/* Update rate of meshes that are not rendered */
+	UPROPERTY(Config)
+	int32 NonRenderedUpdateRate = 8;
+
+	/* Maximum update rate at which skipped frames are still interpolated */
+	UPROPERTY(Config)
+	int32 MaxEvalRateForInterpolation = 4;
+
+	/* Animation sharing setup with the locomotion states of the character skeletons (no sharing if empty) */
+	UPROPERTY(Config)
+	TSoftObjectPtr<UAnimationSharingSetup> SharingSetup;
+
+	/* First significance bucket in which characters share poses instead of evaluating their own animation */
+	UPROPERTY(Config)
+	int32 SharingBucket = 2;
+
+protected:
+
+	/* Characters currently following a shared pose */
+	TSet<TObjectKey<ACharacter>> SharedCharacters;
+
+	/* Apply the configured update rate optimization to the parameters of a mesh */
+	void ApplyUpdateRateParameters(FAnimUpdateRateParameters* Parameters) const;
+
+	/* Hand the mesh of the character over to the animation sharing manager (leaving the budget) or take it back */
+	void SetShared(ACharacter* Character, const bool bShared);
+
+	/* Register the mesh of the character with the budget allocator or remove it */
+	void SetBudgeted(ACharacter* Character, const bool bBudgeted) const;
+
+public:
+
+	/* Start scaling the animation cost of the character. Player characters are always evaluated at full rate */
+	void RegisterCharacter(ACharacter* Character);
+
+	/* Stop scaling the animation cost of the character and restore its own full rate animation */
+	void UnregisterCharacter(ACharacter* Character);
+
+	/* Share or stop sharing the pose of the character when its significance bucket changes */
+	void UpdateSharing(ACharacter* Character, const int32 Bucket);
+
+	/* Check whether the character is following a shared pose */
+	bool IsShared(const ACharacter* Character) const { return SharedCharacters.Contains(Character); }
+};
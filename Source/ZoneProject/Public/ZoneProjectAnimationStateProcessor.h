@@ -0,0 +1,32 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AnimationSharingTypes.h"
+#include "ZoneProjectAnimationStateProcessor.generated.h"
+
+/**
+ * Animation State Processor class. Maps a character to the locomotion state whose shared pose it follows
+ */
+UCLASS(Blueprintable)
+class ZONEPROJECT_API UZoneProjectAnimationStateProcessor : public UAnimationSharingStateProcessor
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Determine the locomotion state of the actor */
+	virtual void ProcessActorState_Implementation(int32& OutState, AActor* InActor, uint8 CurrentState, uint8 OnDemandState, bool& bShouldProcess) override;
+
+	/* Return the enum of the locomotion states */
+	virtual UEnum* GetAnimationStateEnum_Implementation() override;
+
+	/* Ground speed from which the character walks instead of idling */
+	UPROPERTY(EditAnywhere, Category = "States", Meta = (ClampMin = "0", UIMin = "0", ForceUnits = "cm/s"))
+	float WalkSpeed = 10.f;
+
+	/* Ground speed from which the character runs instead of walking */
+	UPROPERTY(EditAnywhere, Category = "States", Meta = (ClampMin = "0", UIMin = "0", ForceUnits = "cm/s"))
+	float RunSpeed = 400.f;
+};
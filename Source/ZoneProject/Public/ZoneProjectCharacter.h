@@ -3,6 +3,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "ZoneProject/ZoneProject.h"
 #include "ZoneProjectTypes.h"
 #include "GameFramework/Character.h"
 #include "ZoneProjectCharacter.generated.h"
@@ -23,12 +24,24 @@ public:
 	/* Set up replication */
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
+	/* Called on the server right before replicating the character */
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+
 	/* Called before initializing components */
 	virtual void PreInitializeComponents() override;
 
 	/* Called after initializing components */
 	virtual void PostInitializeComponents() override;
 
+	/* Return the primary asset id of a Blueprint character class, invalid for the native class and instances */
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+
+	/* Primary asset type of Blueprint character classes */
+	static const FPrimaryAssetType PrimaryAssetType;
+
+	/* Add the weapon and drop item classes the character spawns at runtime to the list */
+	void GetContentPaths(TArray<FSoftObjectPath>& OutPaths) const;
+
 protected:
 
 	/* Called when the game starts or when spawned */
@@ -42,6 +55,12 @@ public:
 	/* Called every frame */
 	virtual void Tick(float DeltaSeconds) override;
 
+	/* Called when the controller of the character changes */
+	virtual void NotifyControllerChanged() override;
+
+	/* Called when the player state is replicated */
+	virtual void OnRep_PlayerState() override;
+
 private:
 	
 	/* Camera boom positioning the camera above the character */
@@ -62,18 +81,34 @@ protected:
 	UPROPERTY(Category = "State", BlueprintReadOnly, EditDefaultsOnly)
 	bool bIsSprinting = false;
 
+	/* Indicates whether the character is waiting in the enemy pool */
+	UPROPERTY(Category = "State", BlueprintReadOnly)
+	bool bIsDormant = false;
+
+	/* Life, sprint and dormant state packed for replication. Clients apply it in OnRep_StateFlags */
+	UPROPERTY(Category = "State", BlueprintReadOnly, ReplicatedUsing = OnRep_StateFlags, Meta = (Bitmask, BitmaskEnum = "/Script/ZoneProject.ECharacterStateFlags"))
+	uint8 StateFlags = 0;
+
 	/* Stats properties */
 	
-	UPROPERTY(Category = "Stats", BlueprintReadOnly, EditDefaultsOnly, Replicated)
+	UPROPERTY(Category = "Stats", BlueprintReadOnly, EditDefaultsOnly)
 	float MaxHealth = 100.f;
 
-	UPROPERTY(Category = "Stats", BlueprintReadOnly, EditDefaultsOnly, Replicated)
+	UPROPERTY(Category = "Stats", BlueprintReadOnly, EditDefaultsOnly)
 	float Health = 100.f;
 
+	/* Quantized copy of the health sent to clients */
+	UPROPERTY(ReplicatedUsing = OnRep_ReplicatedHealth)
+	FQuantizedHealth ReplicatedHealth;
+
+	/* Animation played on death when the ragdoll budget is exhausted */
+	UPROPERTY(Category = "Animation", BlueprintReadOnly, EditDefaultsOnly)
+	class UAnimMontage* DeathMontage = nullptr;
+
 	/* Item properties */
 
 	UPROPERTY(Category = "Items", BlueprintReadOnly, EditDefaultsOnly)
-	TSubclassOf<class AZoneProjectWeapon> DefaultWeaponClass;
+	TSoftClassPtr<class AZoneProjectWeapon> DefaultWeaponClass;
 
 	UPROPERTY(Category = "Items", BlueprintReadOnly, EditDefaultsOnly)
 	FName WeaponSocketName = NAME_None;
@@ -87,19 +122,59 @@ protected:
 	/* Timer handle for removing the character after death */
 	FTimerHandle RemoveTimer;
 
+	/* Server time of the last confirmed client-side hit */
+	double LastHitConfirmTime = 0.0;
+
+	/* Planar movement sent to simulated proxies instead of the full 3D replicated movement */
+	UPROPERTY(ReplicatedUsing = OnRep_PlanarMovement)
+	FPlanarRepMovement PlanarMovement;
+
+	/* Last height sent with the planar movement */
+	float LastReplicatedZ = 0.f;
+
+	/* Server time when the height last changed */
+	double LastZChangeTime = -1.0;
+
+	/* Called when the planar movement is replicated, feeds it into the standard simulated proxy smoothing */
+	UFUNCTION() void OnRep_PlanarMovement();
+
 	/* Called on the server upon receiving point damage */
 	virtual float InternalTakePointDamage(float Damage, struct FPointDamageEvent const& PointDamageEvent,
 		AController* EventInstigator, AActor* DamageCauser) override;
 
+	/* Spawn and attach the @DefaultWeaponClass once it is loaded */
+	void SpawnDefaultWeapon();
+
 	/* Randomly spawn a drop item on the character death based on the @DropItemProbabilities */
 	void SpawnDropItem();
 
-	/* Called from multicast on both the client and the server */
+	/* Called on the server when the health runs out and on clients when the dead state is replicated. Does nothing if already dead */
 	void InternalOnDeath();
 	
 	/* Remove the character after death */
 	UFUNCTION() virtual void RemoveCharacter();
 
+	/* Undo the death state (ragdoll, collision, health) so the character can be reused */
+	void ResetDeathState();
+
+	/* Enable or disable everything a dormant character doesn't need (visibility, collision, ticking) */
+	void ApplyDormancy(const bool bDormant);
+
+	/* Set or clear a replicated state flag (server only) */
+	void SetStateFlag(const ECharacterStateFlags Flag, const bool bEnabled);
+
+	/* Check whether a replicated state flag is set */
+	bool HasStateFlag(const ECharacterStateFlags Flag) const { return EnumHasAnyFlags(static_cast<ECharacterStateFlags>(StateFlags), Flag); }
+
+	/* Called when the state flags are replicated, brings the local state in line with them */
+	UFUNCTION() void OnRep_StateFlags();
+
+	/* Copy the health into its replicated quantized form (server only) */
+	void UpdateReplicatedHealth();
+
+	/* Called when the quantized health is replicated */
+	UFUNCTION() void OnRep_ReplicatedHealth();
+
 public:
 	
     /* Returns the camera boom sub-object */
@@ -114,9 +189,18 @@ public:
 	/* Check whether the character is sprinting */
 	bool IsSprinting() const { return bIsSprinting; }
 
+	/* Check whether the character is waiting in the enemy pool */
+	bool IsDormant() const { return bIsDormant; }
+
+	/* Put the character into the dormant pooled state (server only) */
+	void EnterDormancy();
+
+	/* Re-arm a dormant character at the specified transform (server only) */
+	void ExitDormancy(const FTransform& Transform);
+
 	/* Set the new health amount */
 	UFUNCTION(Category = "Character", BlueprintCallable)
-	void SetHealth(const float Value) { Health = FMath::Clamp(Value, 0.f, MaxHealth); }
+	void SetHealth(const float Value);
 
 	/* Increase the health amount by a specified value */
 	UFUNCTION(Category = "Character", BlueprintCallable)
@@ -139,6 +223,9 @@ public:
 	/* Return the weapon */
 	AZoneProjectWeapon* GetWeapon() const { return Weapon; }
 
+	/* Return the death animation */
+	UAnimMontage* GetDeathMontage() const { return DeathMontage; }
+
 	/* Return the character aim rotation */
 	virtual FRotator GetBaseAimRotation() const override;
 
@@ -166,14 +253,12 @@ public:
 	UFUNCTION(Category = "Character", BlueprintCallable)
 	void SimulateFire(const FRotator Rotation);
 
-public:
-
-	UFUNCTION(NetMulticast, Reliable)
-	void MulticastDeath();
+	/* Report a locally predicted hit to the server for lag-compensated validation */
+	void ReportHit(AZoneProjectCharacter* Target, const FVector& Origin, const FVector& Direction);
 
-	UFUNCTION(Server, Reliable)
-	void ServerFire();
+public:
 
-	UFUNCTION(NetMulticast, Reliable)
-	void MulticastFire(const FRotator Rotation);
+	/* Ask the server to validate a predicted hit. Unreliable, a lost confirmation only loses the damage of one shot */
+	UFUNCTION(Server, Unreliable)
+	void ServerConfirmHit(AZoneProjectCharacter* Target, float Timestamp, FVector_NetQuantize Origin, FVector_NetQuantizeNormal Direction);
 };
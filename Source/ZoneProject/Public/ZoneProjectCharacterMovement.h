@@ -3,10 +3,61 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "ZoneProject/ZoneProject.h"
 #include "ZoneProjectTypes.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/CharacterMovementReplication.h"
 #include "ZoneProjectCharacterMovement.generated.h"
 
+/**
+ * Character Network Move Data class. Sends sprint as a bit and the aim as quantized yaw and pitch instead of the full control rotation
+ */
+struct FZoneProjectCharacterNetworkMoveData : public FCharacterNetworkMoveData
+{
+	typedef FCharacterNetworkMoveData Super;
+
+	/* Number of bits of the quantized aim yaw (0.022 degrees) */
+	static constexpr int32 AimYawBits = 14;
+
+	/* Number of bits of the quantized aim pitch in the -90..90 range (0.7 degrees) */
+	static constexpr int32 AimPitchBits = 8;
+
+	/* Sprint movement flag */
+	bool bWantsToSprint = false;
+
+	/* Quantized aim yaw */
+	uint32 PackedAimYaw = 0;
+
+	/* Quantized aim pitch */
+	uint32 PackedAimPitch = 0;
+
+	/* Fill the move data from a saved move before sending it to the server */
+	virtual void ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType) override;
+
+	/* Serialize the move, replacing the control rotation with the quantized aim */
+	virtual bool Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType) override;
+
+	/* Quantize the aim yaw */
+	static uint32 QuantizeAimYaw(const float Yaw);
+
+	/* Quantize the aim pitch */
+	static uint32 QuantizeAimPitch(const float Pitch);
+
+	/* Return the aim rotation of the quantized yaw and pitch */
+	static FRotator DequantizeAim(const uint32 Yaw, const uint32 Pitch);
+};
+
+/**
+ * Character Network Move Data Container class. Holds the project move data for the new, pending and old moves
+ */
+struct FZoneProjectCharacterNetworkMoveDataContainer : public FCharacterNetworkMoveDataContainer
+{
+	FZoneProjectCharacterNetworkMoveDataContainer();
+
+	/* Move data storage */
+	FZoneProjectCharacterNetworkMoveData MoveData[3];
+};
+
 /**
  * Character Movement Component class
  */
@@ -35,17 +86,72 @@ public:
 	/* Sprint movement flag */
 	uint8 bWantsToSprint : 1;
 
+	/* Aim yaw change in degrees ignored by the moves sent to the server */
+	UPROPERTY(Category = "Character Movement (Networking)", EditAnywhere, AdvancedDisplay, Meta = (ClampMin = "0", UIMin = "0", ForceUnits = "deg"))
+	float AimYawDeadband = 0.25f;
+
+	/* Aim pitch change in degrees ignored by the moves sent to the server */
+	UPROPERTY(Category = "Character Movement (Networking)", EditAnywhere, AdvancedDisplay, Meta = (ClampMin = "0", UIMin = "0", ForceUnits = "deg"))
+	float AimPitchDeadband = 1.f;
+
+	/* Update the quantized aim sent to the server, only when the control rotation moved out of the deadband */
+	void UpdateClientAim(const FRotator& ControlRotation);
+
+	/* Return the quantized aim yaw sent to the server */
+	uint32 GetPackedAimYaw() const { return PackedAimYaw; }
+
+	/* Return the quantized aim pitch sent to the server */
+	uint32 GetPackedAimPitch() const { return PackedAimPitch; }
+
 	/* Return maximum speed for the current state. */
 	virtual float GetMaxSpeed() const override;
 
 	/* Return maximum acceleration for the current state. */
 	virtual float GetMaxAcceleration() const override;
 
-	/* Unpack compressed flags from a saved move and set the movement state accordingly */
-	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+	/* Check whether the character is moved by the horde movement subsystem */
+	bool IsHordeMoving() const { return MovementMode == MOVE_Custom && CustomMovementMode == CMOVE_Horde; }
+
+	/* Return the velocity requested by AI path following since the last call and clear the request */
+	FVector ConsumeHordeDesiredVelocity();
+
+	/* Apply the sprint state of the move received from the client and perform the move */
+	virtual void MoveAutonomous(float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags, const FVector& NewAccel) override;
 
 	/* Get network prediction data for a client game */
 	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+	/* Send the pending acknowledgement or correction to the client, counting the corrections */
+	virtual void SendClientAdjustment() override;
+
+	/* Return the moves received from the client and the corrections sent back since the last call (server only) */
+	void ConsumeNetStats(int32& OutMoves, int32& OutCorrections);
+
+protected:
+
+	/* Called after the movement mode has changed */
+	virtual void OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) override;
+
+	/* Update movement in a custom movement mode */
+	virtual void PhysCustom(float DeltaTime, int32 Iterations) override;
+
+	/* Move data sent and received by the packed movement RPCs */
+	FZoneProjectCharacterNetworkMoveDataContainer MoveDataContainer;
+
+	/* Quantized aim yaw sent with the saved moves */
+	uint32 PackedAimYaw = 0;
+
+	/* Quantized aim pitch sent with the saved moves */
+	uint32 PackedAimPitch = 0;
+
+	/* Moves received from the client since the net stats were consumed */
+	int32 NumServerMoves = 0;
+
+	/* Corrections sent to the client since the net stats were consumed */
+	int32 NumCorrections = 0;
+
+	/* Apply the sprint movement flag */
+	void ApplySprint(const bool bSprint);
 };
 
 /**
@@ -60,6 +166,12 @@ public:
 	/* Sprint movement flag */
 	uint8 bWantsToSprint : 1;
 
+	/* Quantized aim yaw */
+	uint32 PackedAimYaw = 0;
+
+	/* Quantized aim pitch */
+	uint32 PackedAimPitch = 0;
+
 	/* Reset saved properties to the initial state */
 	virtual void Clear() override;
 
@@ -72,9 +184,6 @@ public:
 
 	/* Check whether this move can be combined with the new move for replication without changing any behavior */
 	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* Character, float MaxDelta) const override;
-
-	/* Get a byte containing encoded special movement information (jumping, crouching, sprinting) */
-	virtual uint8 GetCompressedFlags() const override;
 };
 
 /**
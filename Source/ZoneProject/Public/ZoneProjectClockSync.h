@@ -0,0 +1,133 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Time probe answered by the server
+ */
+struct FZoneProjectClockSample
+{
+	/* Local time at the middle of the round trip */
+	double LocalTime = 0.0;
+
+	/* Server time minus local time at the middle of the round trip */
+	double Offset = 0.0;
+
+	/* Round trip time of the probe */
+	double RoundTrip = 0.0;
+};
+
+/**
+ * Clock Sync class. Estimates the server clock from time probes the way NTP does: the probe with the smallest round trip
+ * of every window is the least delayed one, the offset and drift are a linear fit of those probes, and the clock returned
+ * to the game is slewed towards the fit so it never jumps or runs backwards
+ */
+class ZONEPROJECT_API FZoneProjectClockSync
+{
+public:
+
+	/* Number of probes sent right after connecting */
+	int32 BurstProbeCount = 8;
+
+	/* Seconds between the probes of the connect burst */
+	double BurstProbeInterval = 0.1;
+
+	/* Seconds between the probes after the connect burst */
+	double ProbeInterval = 1.0;
+
+	/* Number of probes the least delayed one is taken from */
+	int32 WindowSize = 4;
+
+	/* Number of window samples the fit is computed from */
+	int32 MaxSamples = 16;
+
+	/* A window sample is an outlier when its round trip exceeds the smallest one by this factor plus the jitter allowance */
+	double OutlierRoundTripFactor = 1.5;
+	double OutlierRoundTripJitter = 0.01;
+
+	/* Number of outliers in a row after which the route is considered changed and the samples are discarded */
+	int32 MaxRejectedSamples = 3;
+
+	/* Largest drift of the server clock accepted from the fit */
+	double MaxDrift = 0.01;
+
+	/* Fraction of the elapsed time the returned clock may be corrected by */
+	double MaxSlewRate = 0.05;
+
+	/* Error in seconds above which the returned clock steps instead of slewing */
+	double StepThreshold = 0.25;
+
+protected:
+
+	/* Window samples used by the fit, oldest first */
+	TArray<FZoneProjectClockSample> Samples;
+
+	/* Least delayed probe of the current window */
+	FZoneProjectClockSample WindowBest;
+
+	/* Number of probes received in the current window */
+	int32 WindowCount = 0;
+
+	/* Number of probes sent */
+	int32 ProbesSent = 0;
+
+	/* Number of window samples rejected as outliers in a row */
+	int32 RejectedSamples = 0;
+
+	/* Fitted offset at the reference time and its rate of change */
+	double FitTime = 0.0;
+	double FitOffset = 0.0;
+	double FitDrift = 0.0;
+
+	/* Offset applied to the returned clock, slewed towards the fit */
+	double SmoothedOffset = 0.0;
+
+	/* Local time of the last update of the returned clock */
+	double LastUpdateTime = 0.0;
+
+	/* Last returned server time, the clock never goes below it */
+	double LastServerTime = 0.0;
+
+	/* Smoothed round trip of the least delayed probes */
+	double RoundTrip = 0.0;
+
+	/* Indicates whether a probe has been received */
+	bool bSynchronized = false;
+
+	/* Add the least delayed probe of a window to the fit */
+	void AddSample(const FZoneProjectClockSample& Sample);
+
+	/* Fit the offset and the drift to the samples */
+	void UpdateFit();
+
+public:
+
+	/* Reset the estimate, called when connecting */
+	void Reset();
+
+	/* Return the seconds to wait before sending the next probe and count it as sent */
+	double ScheduleProbe();
+
+	/* Process the answer to a probe sent at @SendTime, stamped with @ServerTime by the server and received at @ReceiveTime */
+	void OnProbeAnswered(const double SendTime, const double ServerTime, const double ReceiveTime);
+
+	/* Slew the returned clock towards the fit, called every frame */
+	void Update(const double LocalTime);
+
+	/* Return the server time at the local time */
+	double GetServerTime(const double LocalTime) const;
+
+	/* Return the fitted server time without smoothing */
+	double GetFittedServerTime(const double LocalTime) const { return LocalTime + FitOffset + FitDrift * (LocalTime - FitTime); }
+
+	/* Return the smoothed round trip of the least delayed probes */
+	double GetRoundTrip() const { return RoundTrip; }
+
+	/* Return the estimated drift of the server clock in seconds per second */
+	double GetDrift() const { return FitDrift; }
+
+	/* Check whether a probe has been received */
+	bool IsSynchronized() const { return bSynchronized; }
+};
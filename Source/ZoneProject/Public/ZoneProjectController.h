@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "InputAction.h"
 #include "ZoneProjectTypes.h"
+#include "ZoneProjectClockSync.h"
 #include "GameFramework/PlayerController.h"
 #include "ZoneProjectController.generated.h"
 
@@ -33,43 +34,12 @@ public:
 
 protected:
 
-	/* Indicates whether the controller has successfully synced time with the server */
-	bool bHasSyncedTime = false;
+	/* Server clock estimated from unreliable time probes (local player only) */
+	FZoneProjectClockSync ClockSync;
 
-	/* Defines how frequently the time should be synced with the server */
-	float TimeSyncFrequency = 5.f;
-
-	/* Timer handle for sending time-sync requests to the server */
+	/* Timer handle for sending time probes to the server */
 	FTimerHandle TimeSyncTimer;
 
-	/* Defines if the last time-sync request was successful */
-	bool bTimeSyncLastStatus = true;
-
-	/* Tracks how many time-sync failures have happened in a row */
-	int32 TimeSyncErrorCount = 0;
-	int32 TimeSyncErrorCountToDisconnect = 5;
-
-	/* Maximum round trip duration to consider the received time info valid */
-	float RoundTripThreshold = 0.4f;
-
-	/* History of the latest calculated round trip values. It can be used to calculate the averaged value */
-	FValueHistory RoundTripHistory;
-
-	/* Maximum number of entries in the round trip history */
-	int32 RoundTripHistoryMaxCount = 2;
-
-	/* Averaged round trip value in seconds (how long it takes to send a request to the server and receive a response) */
-	float RoundTripAverage = 0.f;
-
-	/* History of the latest calculated time delta values. It can be used to calculate the averaged value */
-	FValueHistory TimeDeltaHistory;
-
-	/* Maximum number of entries in the time delta history */
-	int32 TimeDeltaHistoryMaxCount = 10;
-
-	/* Averaged time delta value in seconds (how far the local world time is behind the server time) */
-	float TimeDeltaAverage = 0.f;
-
 protected:
 	
 	/* Default mapping context */
@@ -113,7 +83,7 @@ protected:
 	/* Called after possessing a new pawn (standalone, listen server, client) */
 	virtual void AcknowledgePossession(APawn* InPawn) override;
 
-	/* Trigger the time sync request to further calculate the round trip and the time delta */
+	/* Send a time probe to the server and schedule the next one */
 	void SyncTime();
 
 	/* Input handlers */
@@ -126,29 +96,35 @@ protected:
 
 public:
 
-	/* Return the averaged round trip value in seconds or milliseconds */
+	/* Return the round trip of the least delayed time probes in seconds or milliseconds */
 	UFUNCTION(Category = "Network", BlueprintCallable)
-	float GetRoundTrip(bool bMilliseconds = false) const { return RoundTripAverage * (bMilliseconds ? 1000 : 1); }
+	float GetRoundTrip(bool bMilliseconds = false) const { return ClockSync.GetRoundTrip() * (bMilliseconds ? 1000 : 1); }
 
-	/* Return the averaged time delta value in seconds */
+	/* Return how far the local world time is behind the server time in seconds */
 	UFUNCTION(Category = "Network", BlueprintCallable)
-	float GetTimeDelta() const { return TimeDeltaAverage; }
+	float GetTimeDelta() const { return GetServerTime() - GetLocalTime(); }
 
 	/* Return the actual local time in seconds */
 	UFUNCTION(Category = "Network", BlueprintCallable)
 	float GetLocalTime() const { return GetWorld()->GetTimeSeconds(); }
 
-	/* Return the simulated server time in seconds */
+	/* Return the server time in seconds, smoothed and never running backwards */
 	UFUNCTION(Category = "Network", BlueprintCallable)
-	float GetServerTime() const { return GetLocalTime() + TimeDeltaAverage; }
+	float GetServerTime() const;
+
+	/* Return the server time in seconds with full precision */
+	double GetServerTimePrecise() const;
+
+	/* Return the server time as seen by the local player, or the world time on the server */
+	static float GetSynchronizedTime(const UObject* WorldContextObject);
 
 protected:
 
-	/* Request the current time from the server */
-	UFUNCTION(Server, Reliable)
-	void ServerRequestTime(const float ClientTime);
+	/* Request the current time from the server. A lost probe is simply not answered */
+	UFUNCTION(Server, Unreliable)
+	void ServerRequestTime(const double ClientTime);
 
 	/* Report the current time to the client */
-	UFUNCTION(Client, Reliable)
-	void ClientReportServerTime(const float ClientTime, float ServerTime);
+	UFUNCTION(Client, Unreliable)
+	void ClientReportServerTime(const double ClientTime, const double ServerTime);
 };
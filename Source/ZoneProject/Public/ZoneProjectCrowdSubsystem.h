@@ -0,0 +1,115 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZoneProjectTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ZoneProjectCrowdSubsystem.generated.h"
+
+class AZoneProjectCharacter;
+
+/**
+ * Crowd Subsystem class. Simulates enemies far from every player as lightweight entities (position, health, target, state)
+ * and promotes them to full characters from the enemy pool when they come close to a player, demoting them back when they leave (server only)
+ */
+UCLASS(Config = Game)
+class ZONEPROJECT_API UZoneProjectCrowdSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Called every frame */
+	virtual void Tick(float DeltaTime) override;
+
+	/* Return the stat id used to profile the tick */
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	/* Only game worlds simulate crowds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+public:
+
+	/* Distance to the nearest player within which entities are promoted to characters */
+	UPROPERTY(Config)
+	float PromotionRadius = 3000.f;
+
+	/* Distance to the nearest player beyond which characters are demoted to entities */
+	UPROPERTY(Config)
+	float DemotionRadius = 3600.f;
+
+	/* Maximum number of entities promoted per frame */
+	UPROPERTY(Config)
+	int32 MaxPromotionsPerFrame = 4;
+
+	/* Maximum number of characters demoted per frame */
+	UPROPERTY(Config)
+	int32 MaxDemotionsPerFrame = 4;
+
+	/* Minimum number of entities processed by a single worker task */
+	UPROPERTY(Config)
+	int32 ParallelBatchSize = 256;
+
+protected:
+
+	/* Entity state */
+	enum class EEntityState : uint8
+	{
+		Idle,
+		Chase
+	};
+
+	/* Entity state (structure of arrays, all arrays have the same length) */
+
+	TArray<FVector> Positions;
+	TArray<float> Healths;
+	TArray<float> Speeds;
+	TArray<int32> Targets;
+	TArray<EEntityState> States;
+	TArray<float> TargetDistancesSquared;
+	TArray<TSubclassOf<AZoneProjectCharacter>> Classes;
+
+	/* Characters promoted from entities or spawned near players */
+	TArray<TWeakObjectPtr<AZoneProjectCharacter>> Promoted;
+
+	/* Player pawn locations gathered once per frame */
+	TArray<FVector> PlayerLocations;
+
+	/* Add an entity */
+	void AddEntity(TSubclassOf<AZoneProjectCharacter> EnemyClass, const FVector& Location, const float Health);
+
+	/* Remove the entity at the specified index by swapping the last one into its place */
+	void RemoveEntityAtSwap(const int32 Index);
+
+	/* Move every entity towards its target (runs on worker threads) */
+	void SimulateEntities(const float DeltaTime);
+
+	/* Promote entities close to players to characters */
+	void PromoteEntities();
+
+	/* Demote characters far from players to entities */
+	void DemoteCharacters();
+
+	/* Return the squared distance to the nearest player */
+	float GetNearestPlayerDistanceSquared(const FVector& Location) const;
+
+	/* Spawn a character from the enemy pool */
+	AZoneProjectCharacter* PromoteEntity(TSubclassOf<AZoneProjectCharacter> EnemyClass, const FVector& Location, const float Health);
+
+public:
+
+	/* Spawn an enemy as a character if it is close to a player, otherwise as an entity */
+	UFUNCTION(Category = "Enemy", BlueprintCallable)
+	void SpawnEnemy(TSubclassOf<AZoneProjectCharacter> EnemyClass, const FTransform& Transform);
+
+	/* Return the number of entities */
+	UFUNCTION(Category = "Enemy", BlueprintCallable)
+	int32 GetNumEntities() const { return Positions.Num(); }
+
+	/* Return the number of promoted characters */
+	UFUNCTION(Category = "Enemy", BlueprintCallable)
+	int32 GetNumPromoted() const { return Promoted.Num(); }
+};
@@ -20,15 +20,19 @@ public:
 	/* Class constructor */
 	AZoneProjectDropItem();
 
+	/* Return the primary asset id of Blueprint drop item classes */
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+
+	/* Primary asset type of Blueprint drop item classes */
+	static const FPrimaryAssetType PrimaryAssetType;
+
 protected:
 
 	/* Called when the game starts or when spawned */
 	virtual void BeginPlay() override;
 
-public:
-
-	/* Called every frame */
-	virtual void Tick(float DeltaTime) override;
+	/* Called when the actor is being removed from the level */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
 
@@ -40,6 +44,10 @@ public:
 	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "General")
 	float Amount = 0.f;
 
-	/* Called when this actor begins to overlap with another actor */
-	UFUNCTION() void OnBeginOverlap(AActor* OverlappedActor, AActor* OtherActor);
+	/* Distance from the character capsule at which the item is picked up. Zero uses the collision bounds of the item */
+	UPROPERTY(BlueprintReadOnly, EditDefaultsOnly, Category = "General", Meta = (ClampMin = "0", UIMin = "0", ForceUnits = "cm"))
+	float PickupRadius = 0.f;
+
+	/* Apply the item to the character and destroy it. Return true if the item was picked up */
+	bool TryPickUp(class AZoneProjectCharacter* Character);
 };
@@ -0,0 +1,81 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZoneProjectTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ZoneProjectEnemyPoolSubsystem.generated.h"
+
+class AZoneProjectCharacter;
+
+/**
+ * Pool of dormant enemies of a single class
+ */
+USTRUCT()
+struct FEnemyPool
+{
+	GENERATED_USTRUCT_BODY()
+
+	/* Dormant enemies ready to be re-armed */
+	UPROPERTY()
+	TArray<TObjectPtr<AZoneProjectCharacter>> Available;
+
+	/* Number of enemies re-armed from the pool */
+	int32 Hits = 0;
+
+	/* Number of enemies that had to be spawned because the pool was empty */
+	int32 Misses = 0;
+};
+
+/**
+ * Enemy Pool Subsystem class. Keeps dead enemies in a dormant state with their controller and weapon
+ * and re-arms them on spawn instead of spawning and destroying characters during waves (server only)
+ */
+UCLASS(Config = Game)
+class ZONEPROJECT_API UZoneProjectEnemyPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Called when the subsystem is torn down */
+	virtual void Deinitialize() override;
+
+protected:
+
+	/* Only game worlds pool enemies */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+public:
+
+	/* Maximum number of dormant enemies kept per class, the rest are destroyed */
+	UPROPERTY(Config)
+	int32 MaxDormantEnemies = 64;
+
+protected:
+
+	/* Enemy pools by class */
+	UPROPERTY()
+	TMap<TSubclassOf<AZoneProjectCharacter>, FEnemyPool> Pools;
+
+	/* Spawn a new enemy */
+	AZoneProjectCharacter* SpawnEnemy(TSubclassOf<AZoneProjectCharacter> EnemyClass, const FTransform& Transform) const;
+
+public:
+
+	/* Pre-spawn dormant enemies of the specified class up to @Count */
+	UFUNCTION(Category = "Enemy", BlueprintCallable)
+	void WarmUp(TSubclassOf<AZoneProjectCharacter> EnemyClass, int32 Count);
+
+	/* Re-arm a dormant enemy at the specified transform, or spawn a new one if the pool is empty */
+	UFUNCTION(Category = "Enemy", BlueprintCallable)
+	AZoneProjectCharacter* AcquireEnemy(TSubclassOf<AZoneProjectCharacter> EnemyClass, const FTransform& Transform);
+
+	/* Put a dead enemy into the dormant state and return it to its pool */
+	UFUNCTION(Category = "Enemy", BlueprintCallable)
+	void ReleaseEnemy(AZoneProjectCharacter* Enemy);
+
+	/* Print the usage statistics of all pools to the log */
+	void DumpStats() const;
+};
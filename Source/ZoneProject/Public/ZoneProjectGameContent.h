@@ -0,0 +1,31 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "ZoneProjectGameContent.generated.h"
+
+/**
+ * Game Content class. Lists the gameplay classes a game mode spawns during a match, so their asset bundle
+ * can be preloaded asynchronously while the map loads
+ */
+UCLASS(BlueprintType)
+class ZONEPROJECT_API UZoneProjectGameContent : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Enemy and player character classes */
+	UPROPERTY(Category = "Classes", BlueprintReadOnly, EditDefaultsOnly, Meta = (AssetBundles = "Match"))
+	TArray<TSoftClassPtr<class AZoneProjectCharacter>> Characters;
+
+	/* Weapon classes of the characters */
+	UPROPERTY(Category = "Classes", BlueprintReadOnly, EditDefaultsOnly, Meta = (AssetBundles = "Match"))
+	TArray<TSoftClassPtr<class AZoneProjectWeapon>> Weapons;
+
+	/* Item classes dropped by the characters */
+	UPROPERTY(Category = "Classes", BlueprintReadOnly, EditDefaultsOnly, Meta = (AssetBundles = "Match"))
+	TArray<TSoftClassPtr<class AZoneProjectDropItem>> DropItems;
+};
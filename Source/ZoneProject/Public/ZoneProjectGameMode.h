@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "ZoneProjectTypes.h"
+#include "Engine/StreamableManager.h"
 #include "GameFramework/GameModeBase.h"
 #include "ZoneProjectGameMode.generated.h"
 
@@ -20,6 +21,9 @@ public:
 	/* Class constructor */
 	AZoneProjectGameMode();
 
+	/* Called when the map is loaded, before any actor begins play */
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+
 protected:
 
 	/* Called when the game starts or when spawned */
@@ -29,23 +33,81 @@ public:
 
 	/* Default enemy class */
 	UPROPERTY(Category = "Classes", EditAnywhere, BlueprintReadWrite)
-	TSubclassOf<class AZoneProjectCharacter> DefaultEnemyClass;
+	TSoftClassPtr<class AZoneProjectCharacter> DefaultEnemyClass;
+
+	/* Gameplay classes of the match, their @PreloadBundle is loaded with the map */
+	UPROPERTY(Category = "Classes", BlueprintReadOnly, EditDefaultsOnly)
+	TSoftObjectPtr<class UZoneProjectGameContent> GameContent;
+
+	/* Asset bundle of the game content preloaded when the map is loaded */
+	UPROPERTY(Category = "Classes", BlueprintReadOnly, EditDefaultsOnly)
+	FName PreloadBundle = TEXT("Match");
 
-	/* Frequency of spawning a new enemy */
+	/* Seconds between enemy waves */
 	UPROPERTY(Category = "Game", BlueprintReadOnly, EditDefaultsOnly)
 	float EnemySpawnRate = 5.f;
 
-	/* Frequency of spawning a new enemy */
+	/* Distance from a player to the enemy spawn positions */
 	UPROPERTY(Category = "Game", BlueprintReadOnly, EditDefaultsOnly)
 	float EnemySpawnDistance = 1500.f;
 
+	/* Minimum distance from other characters to the enemy spawn position */
+	UPROPERTY(Category = "Game", BlueprintReadOnly, EditDefaultsOnly, Meta = (ClampMin = "0", UIMin = "0", ForceUnits = "cm"))
+	float EnemySpawnClearance = 100.f;
+
+	/* Number of enemies spawned around every player by the first wave */
+	UPROPERTY(Category = "Game", BlueprintReadOnly, EditDefaultsOnly, Meta = (ClampMin = "0", UIMin = "0"))
+	int32 WaveEnemiesPerPlayer = 1;
+
+	/* Number of enemies per player added by every following wave */
+	UPROPERTY(Category = "Game", BlueprintReadOnly, EditDefaultsOnly, Meta = (ClampMin = "0", UIMin = "0"))
+	float WaveEnemiesPerPlayerGrowth = 0.5f;
+
+	/* Maximum number of enemies spawned around every player by a wave */
+	UPROPERTY(Category = "Game", BlueprintReadOnly, EditDefaultsOnly, Meta = (ClampMin = "1", UIMin = "1"))
+	int32 MaxWaveEnemiesPerPlayer = 8;
+
+	/* Number of dormant enemies spawned when the game starts */
+	UPROPERTY(Category = "Game", BlueprintReadOnly, EditDefaultsOnly, Meta = (ClampMin = "0", UIMin = "0"))
+	int32 EnemyPoolSize = 16;
+
 protected:
 
-	/* Timer handle for spawning enemies */
-	FTimerHandle RemoveTimer;
+	/* Timer handle for starting waves */
+	FTimerHandle WaveTimer;
+
+	/* Number of waves started */
+	int32 WaveNumber = 0;
+
+	/* Handles keeping the preloaded classes in memory */
+	TArray<TSharedPtr<FStreamableHandle>> PreloadHandles;
+
+	/* Indicates whether the preloaded classes have been loaded */
+	bool bGameContentReady = false;
 
 protected:
 
-	/* Spawn an enemy character */
-	UFUNCTION() virtual void SpawnEnemy();
+	/* Start loading the bundle of the game content and the enemy and pawn classes */
+	void PreloadGameContent();
+
+	/* Called when the first classes have been loaded, starts loading the weapons and drop items missing from the game content */
+	void OnGameClassesLoaded();
+
+	/* Called when the preloaded classes have been loaded */
+	void OnGameContentLoaded();
+
+	/* Keep the loading classes in memory and call @Callback once all of them have been loaded */
+	void WaitForPreload(TArray<TSharedPtr<FStreamableHandle>> Handles, const FStreamableDelegate& Callback);
+
+	/* Fill the enemy pool and start the wave timer, once the game has begun and the classes are loaded */
+	void StartWaves();
+
+	/* Queue the next enemy wave on the wave director */
+	UFUNCTION() virtual void StartWave();
+
+public:
+
+	/* Check whether the preloaded classes have been loaded, nothing is spawned before */
+	UFUNCTION(Category = "Game", BlueprintCallable)
+	bool IsGameContentReady() const { return bGameContentReady; }
 };
@@ -0,0 +1,120 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZoneProjectTypes.h"
+#include "AI/Navigation/NavigationTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ZoneProjectHordeMovementSubsystem.generated.h"
+
+class AZoneProjectCharacter;
+
+/**
+ * Horde Movement Subsystem class. Moves AI enemies far from players kinematically in one batch per frame
+ * instead of running the full character movement for each of them. Velocities and separation are integrated
+ * on worker threads and the results are projected onto the navmesh (server only)
+ */
+UCLASS(Config = Game)
+class ZONEPROJECT_API UZoneProjectHordeMovementSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Called every frame */
+	virtual void Tick(float DeltaTime) override;
+
+	/* Return the stat id used to profile the tick */
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	/* Only game worlds move hordes */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+public:
+
+	/* Distance to the nearest player within which enemies use the full character movement */
+	UPROPERTY(Config)
+	float FullMovementDistance = 1500.f;
+
+	/* Extra distance an enemy must move away from the players before it switches to the horde movement */
+	UPROPERTY(Config)
+	float HysteresisDistance = 300.f;
+
+	/* Distance within which enemies push each other apart */
+	UPROPERTY(Config)
+	float SeparationRadius = 100.f;
+
+	/* Strength of the separation push relative to the maximum acceleration */
+	UPROPERTY(Config)
+	float SeparationStrength = 0.5f;
+
+	/* Extent of the navmesh projection query */
+	UPROPERTY(Config)
+	FVector ProjectionExtent = FVector(50.f, 50.f, 250.f);
+
+	/* Minimum number of enemies processed by a single worker task */
+	UPROPERTY(Config)
+	int32 ParallelBatchSize = 32;
+
+protected:
+
+	/* All registered characters */
+	TArray<TWeakObjectPtr<AZoneProjectCharacter>> Characters;
+
+	/* Horde state of the characters currently moved by the subsystem (structure of arrays, all arrays have the same length) */
+
+	TArray<AZoneProjectCharacter*> Members;
+	TArray<FVector> Positions;
+	TArray<FVector> NewPositions;
+	TArray<FVector> Velocities;
+	TArray<FVector> DesiredVelocities;
+	TArray<float> Yaws;
+	TArray<float> MaxSpeeds;
+	TArray<float> MaxAccelerations;
+	TArray<float> TurnRates;
+	TArray<float> HalfHeights;
+
+	/* Uniform grid used to find neighbors for the separation, rebuilt every frame */
+
+	TArray<uint64> CellKeys;
+	TArray<int32> SortedMembers;
+	TMap<uint64, int32> CellStarts;
+
+	/* Per-frame scratch buffer reused for the navmesh projection */
+	TArray<FNavigationProjectionWork> ProjectionWork;
+
+	/* Player pawn locations gathered once per frame */
+	TArray<FVector> PlayerLocations;
+
+	/* Switch characters between the full and the horde movement and gather the state of the horde */
+	void GatherMembers();
+
+	/* Check whether the character may use the horde movement */
+	bool CanUseHordeMovement(const AZoneProjectCharacter* Character, const bool bIsHordeMoving) const;
+
+	/* Sort the members into the separation grid */
+	void BuildGrid();
+
+	/* Integrate velocities and separation (runs on worker threads) */
+	void SimulateMembers(const float DeltaTime);
+
+	/* Project the new positions onto the navmesh and move the characters (game thread) */
+	void ApplyMembers();
+
+	/* Return the grid cell key of the location */
+	uint64 GetCellKey(const FVector& Location) const;
+
+public:
+
+	/* Start managing the movement of the character */
+	void RegisterCharacter(AZoneProjectCharacter* Character);
+
+	/* Stop managing the movement of the character and restore the full movement */
+	void UnregisterCharacter(AZoneProjectCharacter* Character);
+
+	/* Return the number of characters currently moved as a horde */
+	int32 GetNumMembers() const { return Members.Num(); }
+};
@@ -0,0 +1,130 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZoneProjectTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ZoneProjectLagCompensationSubsystem.generated.h"
+
+class AZoneProjectCharacter;
+
+/**
+ * Hitbox state of a character at a moment in time
+ */
+struct FZoneProjectHitboxFrame
+{
+	/* Server world time of the frame */
+	double Time = 0.0;
+
+	/* Capsule center */
+	FVector Location = FVector::ZeroVector;
+
+	/* Capsule rotation */
+	FQuat Rotation = FQuat::Identity;
+
+	/* Capsule dimensions */
+	float Radius = 0.f;
+	float HalfHeight = 0.f;
+};
+
+/**
+ * Fixed-capacity ring buffer of hitbox frames of a single character
+ */
+struct FZoneProjectHitboxHistory
+{
+	/* Character the history belongs to */
+	TWeakObjectPtr<AZoneProjectCharacter> Character;
+
+	/* Key of the character in the index map, still valid once the character is gone */
+	TObjectKey<AZoneProjectCharacter> Key;
+
+	/* Preallocated frames, written in a circle */
+	TArray<FZoneProjectHitboxFrame> Frames;
+
+	/* Index of the next frame to write */
+	int32 Head = 0;
+
+	/* Number of valid frames */
+	int32 Num = 0;
+
+	/* Return the frame that is @Age frames older than the latest one */
+	const FZoneProjectHitboxFrame& GetFrame(const int32 Age) const
+	{
+		return Frames[(Head - 1 - Age + Frames.Num()) % Frames.Num()];
+	}
+};
+
+/**
+ * Lag Compensation Subsystem class. Records the hitbox history of every character on the server
+ * and rewinds it to validate hits reported by clients at their own timestamp
+ */
+UCLASS(Config = Game)
+class ZONEPROJECT_API UZoneProjectLagCompensationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Called every frame */
+	virtual void Tick(float DeltaTime) override;
+
+	/* Return the stat id used to profile the tick */
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	/* Only game worlds record hitboxes */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+public:
+
+	/* Maximum time in seconds a hit can be rewound */
+	UPROPERTY(Config)
+	float MaxRewindTime = 0.5f;
+
+	/* Maximum time in seconds a reported timestamp may be ahead of the server clock */
+	UPROPERTY(Config)
+	float MaxFutureTime = 0.05f;
+
+	/* Number of hitbox frames recorded per second */
+	UPROPERTY(Config)
+	float RecordRate = 60.f;
+
+	/* Extra distance added to the capsule radius to absorb quantization and interpolation errors */
+	UPROPERTY(Config)
+	float HitTolerance = 15.f;
+
+	/* Maximum distance from the reported shot origin to the shooter capsule, covering the muzzle offset and the prediction error */
+	UPROPERTY(Config)
+	float MaxOriginDistance = 200.f;
+
+protected:
+
+	/* Histories of all registered characters */
+	TArray<FZoneProjectHitboxHistory> Histories;
+
+	/* History index by character */
+	TMap<TObjectKey<AZoneProjectCharacter>, int32> HistoryIndices;
+
+	/* World time when the last frame was recorded */
+	double LastRecordTime = -1.0;
+
+	/* Record the current hitbox of every registered character */
+	void RecordFrames(const double Time);
+
+public:
+
+	/* Start recording the hitbox history of the character */
+	void RegisterCharacter(AZoneProjectCharacter* Character);
+
+	/* Stop recording the hitbox history of the character */
+	void UnregisterCharacter(AZoneProjectCharacter* Character);
+
+	/* Find the interpolated hitbox of the character at the specified server time */
+	bool GetHitboxAtTime(const AZoneProjectCharacter* Character, const double Time, FZoneProjectHitboxFrame& OutFrame) const;
+
+	/* Check whether the shot of @Shooter from @Origin in @Direction could hit the character at the specified server time */
+	bool ValidateHit(const AZoneProjectCharacter* Shooter, const AZoneProjectCharacter* Character, const double Time, const FVector& Origin,
+		const FVector& Direction, const float MaxDistance) const;
+};
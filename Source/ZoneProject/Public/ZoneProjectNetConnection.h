@@ -0,0 +1,29 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IpConnection.h"
+#include "ZoneProjectNetConnection.generated.h"
+
+/**
+ * Net Connection class. Counts the outgoing bits of every bunch by the class of the actor it belongs to, for the net telemetry
+ */
+UCLASS(Transient, Config = Engine)
+class ZONEPROJECT_API UZoneProjectNetConnection : public UIpConnection
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Count the bits of the bunch before sending it */
+	virtual int32 SendRawBunch(FOutBunch& Bunch, bool InAllowMerge, const FNetTraceCollector* BunchCollector) override;
+
+	/* Move the bits sent by actor class since the last call to @OutBits */
+	void ConsumeOutBitsByClass(TMap<FName, int64>& OutBits);
+
+protected:
+
+	/* Bits sent by actor class since the last consumption. Bunches of other channels are counted as the channel name */
+	TMap<FName, int64> OutBitsByClass;
+};
@@ -0,0 +1,132 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZoneProjectRollingStatistics.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ZoneProjectNetTelemetrySubsystem.generated.h"
+
+class UNetConnection;
+
+/**
+ * Telemetry of a single client connection
+ */
+struct FZoneProjectConnectionTelemetry
+{
+	/* Player name and address */
+	FString Name;
+
+	/* Round trip samples in milliseconds */
+	TRollingStatistics<float> RoundTrip;
+
+	/* Packet loss in percent */
+	float InLoss = 0.f;
+	float OutLoss = 0.f;
+
+	/* Bandwidth in bytes per second */
+	int32 InBytesPerSecond = 0;
+	int32 OutBytesPerSecond = 0;
+
+	/* Largest and total number of unacknowledged reliable bunches over the open channels */
+	int32 ReliableBufferMax = 0;
+	int32 ReliableBufferTotal = 0;
+
+	/* Moves received from the client and corrections sent back per second */
+	float MovesPerSecond = 0.f;
+	float CorrectionsPerSecond = 0.f;
+
+	/* Outgoing bytes per second by actor class */
+	TMap<FName, float> OutBytesByClass;
+
+	/* Calls per second by RPC name */
+	TMap<FName, float> RpcRates;
+
+	/* Calls by RPC name since the last sample */
+	TMap<FName, int32> PendingRpcCounts;
+};
+
+/**
+ * Net Telemetry Subsystem class. Samples what every client connection costs the server: round trip, jitter, packet loss,
+ * bandwidth by actor class, reliable buffer occupancy, movement corrections and RPC rates. Exposes them as stats
+ * and a console command, and appends them to CSV files in the Saved/Telemetry folder
+ */
+UCLASS(Config = Game)
+class ZONEPROJECT_API UZoneProjectNetTelemetrySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Called when the subsystem is destroyed */
+	virtual void Deinitialize() override;
+
+	/* Called every frame */
+	virtual void Tick(float DeltaTime) override;
+
+	/* Return the stat id used to profile the tick */
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	/* Only game worlds have client connections */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+public:
+
+	/* Indicates whether connections are sampled. Off by default, enable it in the config of playtest servers */
+	UPROPERTY(Config)
+	bool bEnabled = false;
+
+	/* Seconds between samples */
+	UPROPERTY(Config)
+	float SampleInterval = 1.f;
+
+	/* Number of round trip samples the jitter and percentiles are computed from */
+	UPROPERTY(Config)
+	int32 RoundTripHistorySize = 60;
+
+	/* Indicates whether the samples are written to CSV files */
+	UPROPERTY(Config)
+	bool bWriteCsv = false;
+
+	/* Seconds between CSV writes */
+	UPROPERTY(Config)
+	float CsvInterval = 10.f;
+
+protected:
+
+	/* Telemetry by client connection */
+	TMap<TObjectKey<UNetConnection>, FZoneProjectConnectionTelemetry> Connections;
+
+	/* Time since the last sample */
+	float SampleElapsed = 0.f;
+
+	/* Time since the last CSV write */
+	float CsvElapsed = 0.f;
+
+	/* Rows sampled since the last CSV write */
+	FString PendingConnectionRows;
+	FString PendingClassRows;
+
+	/* CSV file paths, chosen by the first write */
+	FString ConnectionCsvPath;
+	FString ClassCsvPath;
+
+	/* Sample all client connections */
+	void Sample(const float Elapsed);
+
+	/* Append the pending rows to the CSV files */
+	void FlushCsv();
+
+public:
+
+	/* Count a call of the RPC on the connection owning the actor (server only) */
+	static void RecordRpc(const AActor* Actor, const FName Rpc);
+
+	/* Return the telemetry by client connection */
+	const TMap<TObjectKey<UNetConnection>, FZoneProjectConnectionTelemetry>& GetConnections() const { return Connections; }
+
+	/* Print the latest sample of every connection and the classes using most of its bandwidth */
+	void DumpStats() const;
+};
@@ -0,0 +1,111 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "ZoneProject/ZoneProject.h"
+#include "ZoneProjectTypes.h"
+#include "GameFramework/Actor.h"
+#include "ZoneProjectProjectile.generated.h"
+
+/**
+ * Projectile class. Instances are recycled by the projectile subsystem instead of being destroyed
+ */
+UCLASS(Blueprintable)
+class ZONEPROJECT_API AZoneProjectProjectile : public AActor
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Class constructor */
+	AZoneProjectProjectile();
+
+protected:
+
+	/* Called when the game starts or when spawned */
+	virtual void BeginPlay() override;
+
+private:
+
+	UPROPERTY(Category = "Components", BlueprintReadOnly, EditDefaultsOnly, Meta = (AllowPrivateAccess = "true"))
+	class USphereComponent* Collision;
+
+	UPROPERTY(Category = "Components", BlueprintReadOnly, EditDefaultsOnly, Meta = (AllowPrivateAccess = "true"))
+	class UProjectileMovementComponent* Movement;
+
+public:
+
+	/* Damage applied to the hit actor */
+	UPROPERTY(Category = "Stats", BlueprintReadOnly, EditDefaultsOnly)
+	float Damage = 10.f;
+
+	/* Indicates whether the projectile applies damage (only on the server) */
+	UPROPERTY(Category = "Stats", BlueprintReadOnly, EditDefaultsOnly)
+	bool bDealDamage = false;
+
+	/* Time in seconds before an in-flight projectile returns to the pool */
+	UPROPERTY(Category = "Stats", BlueprintReadOnly, EditDefaultsOnly, Meta = (ClampMin = "0.01", UIMin = "0.01"))
+	float LifeTime = 3.f;
+
+	/* Number of instances created when the pool for this class is warmed up */
+	UPROPERTY(Category = "Pool", BlueprintReadOnly, EditDefaultsOnly, Meta = (ClampMin = "0", UIMin = "0"))
+	int32 PoolSize = 32;
+
+	/* Maximum number of instances the pool for this class may hold (0 means unlimited) */
+	UPROPERTY(Category = "Pool", BlueprintReadOnly, EditDefaultsOnly, Meta = (ClampMin = "0", UIMin = "0"))
+	int32 MaxPoolSize = 256;
+
+	/* What to do when all instances are in flight and the pool has reached @MaxPoolSize */
+	UPROPERTY(Category = "Pool", BlueprintReadOnly, EditDefaultsOnly)
+	EProjectilePoolOverflow OverflowPolicy = EProjectilePoolOverflow::RecycleOldest;
+
+protected:
+
+	/* Indicates whether the projectile is currently in flight */
+	bool bIsActive = false;
+
+	/* World time when the projectile was taken from the pool */
+	double ActivationTime = 0.0;
+
+	/* Transform the projectile was launched from */
+	FTransform LaunchTransform;
+
+	/* Timer handle for returning the projectile to the pool */
+	FTimerHandle LifeTimer;
+
+	/* Called when the collision component hits something */
+	UFUNCTION() void OnHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp,
+		FVector NormalImpulse, const FHitResult& Hit);
+
+public:
+
+	/* Launch the projectile from the specified transform (called by the projectile subsystem) */
+	void Activate(const FTransform& Transform, AActor* InOwner, APawn* InInstigator);
+
+	/* Reset the projectile into the dormant pooled state (called by the projectile subsystem) */
+	void Deactivate();
+
+	/* Return the projectile to the pool */
+	UFUNCTION(Category = "Projectile", BlueprintCallable)
+	void Release();
+
+	/* Check whether the projectile is currently in flight */
+	bool IsActive() const { return bIsActive; }
+
+	/* Return the world time when the projectile was taken from the pool */
+	double GetActivationTime() const { return ActivationTime; }
+
+	/* Return the collision component */
+	USphereComponent* GetCollision() const { return Collision; }
+
+	/* Return the projectile movement component */
+	UProjectileMovementComponent* GetMovement() const { return Movement; }
+
+	/* Blueprint implementable events */
+
+	UFUNCTION(Category = "Projectile", BlueprintImplementableEvent)
+	void OnLaunched();
+
+	UFUNCTION(Category = "Projectile", BlueprintImplementableEvent)
+	void OnImpact(const FHitResult& Hit);
+};
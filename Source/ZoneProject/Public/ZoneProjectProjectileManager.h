@@ -0,0 +1,111 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZoneProjectTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ZoneProjectProjectileManager.generated.h"
+
+/**
+ * Projectile Manager class. Simulates all batched projectiles of the world in one update per frame without spawning actors.
+ * Projectiles are stored as a structure of arrays, swept in parallel against the Projectile channel and drawn by a single instanced mesh
+ */
+UCLASS(Config = Game)
+class ZONEPROJECT_API UZoneProjectProjectileManager : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Called when the subsystem is created */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/* Called when the subsystem is torn down */
+	virtual void Deinitialize() override;
+
+	/* Called when the world begins play */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/* Called every frame */
+	virtual void Tick(float DeltaTime) override;
+
+	/* Return the stat id used to profile the tick */
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	/* Only game worlds simulate projectiles */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+protected:
+
+	/* Mesh used to draw every projectile */
+	UPROPERTY(Config)
+	TSoftObjectPtr<class UStaticMesh> VisualMesh;
+
+	/* Material override for the projectile mesh */
+	UPROPERTY(Config)
+	TSoftObjectPtr<class UMaterialInterface> VisualMaterial;
+
+	/* Scale applied to the projectile mesh */
+	UPROPERTY(Config)
+	FVector VisualScale = FVector(0.1f);
+
+	/* Radius of the sphere swept for every projectile */
+	UPROPERTY(Config)
+	float CollisionRadius = 5.f;
+
+	/* Minimum number of projectiles processed by a single worker task */
+	UPROPERTY(Config)
+	int32 ParallelBatchSize = 64;
+
+	/* Actor hosting the instanced visual */
+	UPROPERTY(Transient)
+	TObjectPtr<AActor> VisualActor;
+
+	/* Single instanced mesh drawing all projectiles */
+	UPROPERTY(Transient)
+	TObjectPtr<class UInstancedStaticMeshComponent> Visual;
+
+	/* Projectile state (structure of arrays, all arrays have the same length) */
+
+	TArray<FVector> Origins;
+	TArray<FVector> Positions;
+	TArray<FVector> Velocities;
+	TArray<float> LifeTimes;
+	TArray<float> Damages;
+	TArray<TWeakObjectPtr<APawn>> Instigators;
+	TArray<bool> DealDamage;
+
+	/* Per-frame scratch buffers reused to avoid allocations */
+
+	TArray<const AActor*> IgnoredActors;
+	TArray<FHitResult> HitResults;
+	TArray<bool> HitFlags;
+	TArray<FTransform> InstanceTransforms;
+	TArray<FTransform> AddedTransforms;
+	TArray<int32> RemovedInstances;
+
+	/* Remove the projectile at the specified index by swapping the last one into its place */
+	void RemoveProjectileAtSwap(const int32 Index);
+
+	/* Advance and sweep every projectile (runs on worker threads) */
+	void SimulateProjectiles(const float DeltaTime);
+
+	/* Apply damage for the hits found during the simulation and remove expired projectiles (game thread) */
+	void ResolveProjectiles();
+
+	/* Synchronize the instanced visual with the projectile positions */
+	void UpdateVisual();
+
+public:
+
+	/* Launch a batched projectile */
+	UFUNCTION(Category = "Projectile", BlueprintCallable)
+	void LaunchProjectile(const FVector& Location, const FVector& Velocity, float LifeTime, float Damage, APawn* Instigator, bool bDealDamage);
+
+	/* Return the number of projectiles in flight */
+	UFUNCTION(Category = "Projectile", BlueprintCallable)
+	int32 GetNumProjectiles() const { return Positions.Num(); }
+};
@@ -0,0 +1,79 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZoneProjectTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ZoneProjectProjectileSubsystem.generated.h"
+
+class AZoneProjectProjectile;
+
+/**
+ * Pool of projectile instances of a single class
+ */
+USTRUCT()
+struct FProjectilePool
+{
+	GENERATED_USTRUCT_BODY()
+
+	/* Dormant instances ready to be launched */
+	UPROPERTY()
+	TArray<TObjectPtr<AZoneProjectProjectile>> Available;
+
+	/* Instances currently in flight */
+	UPROPERTY()
+	TArray<TObjectPtr<AZoneProjectProjectile>> Active;
+
+	/* Usage statistics used to size the pool per map */
+	UPROPERTY()
+	FProjectilePoolStats Stats;
+
+	/* Return the total number of instances owned by the pool */
+	int32 Num() const { return Available.Num() + Active.Num(); }
+};
+
+/**
+ * Projectile Subsystem class. Pre-allocates and recycles projectile actors to avoid spawning and destroying them per shot
+ */
+UCLASS()
+class ZONEPROJECT_API UZoneProjectProjectileSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Called when the subsystem is torn down */
+	virtual void Deinitialize() override;
+
+protected:
+
+	/* Projectile pools by class */
+	UPROPERTY()
+	TMap<TSubclassOf<AZoneProjectProjectile>, FProjectilePool> Pools;
+
+	/* Spawn a new dormant projectile instance */
+	AZoneProjectProjectile* SpawnInstance(TSubclassOf<AZoneProjectProjectile> ProjectileClass) const;
+
+public:
+
+	/* Pre-allocate the pool for the specified class up to its configured pool size */
+	UFUNCTION(Category = "Projectile", BlueprintCallable)
+	void WarmUp(TSubclassOf<AZoneProjectProjectile> ProjectileClass);
+
+	/* Take a projectile from the pool and launch it. Returns null if the overflow policy rejected the request */
+	UFUNCTION(Category = "Projectile", BlueprintCallable)
+	AZoneProjectProjectile* AcquireProjectile(TSubclassOf<AZoneProjectProjectile> ProjectileClass, const FTransform& Transform,
+		AActor* Owner, APawn* Instigator);
+
+	/* Return a projectile to its pool. Releasing an already pooled projectile does nothing */
+	UFUNCTION(Category = "Projectile", BlueprintCallable)
+	void ReleaseProjectile(AZoneProjectProjectile* Projectile);
+
+	/* Return the usage statistics of the pool for the specified class */
+	UFUNCTION(Category = "Projectile", BlueprintCallable)
+	FProjectilePoolStats GetPoolStats(TSubclassOf<AZoneProjectProjectile> ProjectileClass) const;
+
+	/* Print the usage statistics of all pools to the log */
+	void DumpStats() const;
+};
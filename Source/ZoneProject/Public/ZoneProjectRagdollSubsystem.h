@@ -0,0 +1,89 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZoneProjectTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ZoneProjectRagdollSubsystem.generated.h"
+
+class AZoneProjectCharacter;
+
+/**
+ * Simulation state of a single ragdoll
+ */
+struct FZoneProjectRagdoll
+{
+	/* Character whose mesh is simulating */
+	TWeakObjectPtr<AZoneProjectCharacter> Character;
+
+	/* World time when the simulation started */
+	double StartTime = 0.0;
+
+	/* Time in seconds the ragdoll has been below the settle speed */
+	float SettledTime = 0.f;
+};
+
+/**
+ * Ragdoll Subsystem class. Limits the number of concurrently simulated death ragdolls,
+ * falls back to an animated or frozen death pose over the limit and puts settled ragdolls to sleep
+ */
+UCLASS(Config = Game)
+class ZONEPROJECT_API UZoneProjectRagdollSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Called every frame */
+	virtual void Tick(float DeltaTime) override;
+
+	/* Return the stat id used to profile the tick */
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	/* Only game worlds simulate ragdolls */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+public:
+
+	/* Maximum number of ragdolls simulated at the same time */
+	UPROPERTY(Config)
+	int32 MaxRagdolls = 12;
+
+	/* Speed of the pelvis below which a ragdoll is considered settling */
+	UPROPERTY(Config)
+	float SettleSpeed = 10.f;
+
+	/* Time in seconds a ragdoll must stay below @SettleSpeed before it is put to sleep */
+	UPROPERTY(Config)
+	float SettleTime = 0.5f;
+
+	/* Time in seconds after which a ragdoll is put to sleep even if it is still moving */
+	UPROPERTY(Config)
+	float MaxSimulationTime = 5.f;
+
+	/* Simulate ragdolls on a dedicated server (nobody sees them there, so only needed if gameplay depends on them) */
+	UPROPERTY(Config)
+	bool bSimulateOnDedicatedServer = false;
+
+protected:
+
+	/* Ragdolls currently simulating */
+	TArray<FZoneProjectRagdoll> Ragdolls;
+
+	/* Stop simulating the ragdoll at the specified index and keep its last pose */
+	void SleepRagdollAtSwap(const int32 Index);
+
+public:
+
+	/* Put the dying character into a ragdoll if the budget allows it, otherwise into an animated or frozen death pose */
+	void StartDeathPose(AZoneProjectCharacter* Character);
+
+	/* Stop tracking the character (called when it is re-armed or destroyed) */
+	void StopDeathPose(AZoneProjectCharacter* Character);
+
+	/* Return the number of ragdolls currently simulating */
+	int32 GetNumRagdolls() const { return Ragdolls.Num(); }
+};
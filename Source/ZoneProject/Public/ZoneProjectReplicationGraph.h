@@ -0,0 +1,190 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "ZoneProjectReplicationGraph.generated.h"
+
+/**
+ * How actors of a class are routed to the replication graph nodes
+ */
+enum class EZoneProjectRepNodeMapping : uint8
+{
+	/* Not routed to any node, replicated by a connection node or as a dependent actor */
+	NotRouted,
+
+	/* Not routed to any node, gathered from the spatial hash by the camera footprint node of every connection */
+	CameraFootprint,
+
+	/* Replicated to every connection */
+	RelevantAllConnections,
+
+	/* Spatialized once, never moves */
+	Spatialize_Static,
+
+	/* Spatialized every frame */
+	Spatialize_Dynamic,
+
+	/* Spatialized while awake, not moving while dormant */
+	Spatialize_Dormancy
+};
+
+/**
+ * Ground area seen by the top-down camera. A trapezoid relative to the view target, along the yaw of the camera
+ */
+struct FZoneProjectViewFootprint
+{
+	/* Distance from the view target to the bottom edge of the screen, negative behind the view target */
+	float NearForward = 0.f;
+
+	/* Half width of the bottom edge of the screen */
+	float NearHalfWidth = 0.f;
+
+	/* Distance from the view target to the top edge of the screen */
+	float FarForward = 0.f;
+
+	/* Half width of the top edge of the screen */
+	float FarHalfWidth = 0.f;
+
+	/* Check whether the point, relative to the view target along the camera yaw, is inside the footprint grown by the margin */
+	bool Contains(const FVector2D& Point, const float Margin) const;
+
+	/* Return the distance from the view target to the farthest corner */
+	float GetRadius() const;
+};
+
+/**
+ * Replication Graph class. Replaces the per-connection relevancy checks of the net driver: characters and drop items are only relevant
+ * inside the ground footprint of the top-down camera of a connection, other spatialized actors are bucketed in a 2D grid sized to it,
+ * weapons replicate with their characters and the own pawn and controller of every connection are always relevant
+ */
+UCLASS(Transient, Config = Engine)
+class ZONEPROJECT_API UZoneProjectReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Set up the replication settings of the actor classes */
+	virtual void InitGlobalActorClassSettings() override;
+
+	/* Create the nodes shared by all connections */
+	virtual void InitGlobalGraphNodes() override;
+
+	/* Create the nodes of a new connection */
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+
+	/* Add a new replicated actor to the nodes of its class */
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+
+	/* Remove a replicated actor from the nodes of its class */
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+
+	/* Length of the camera boom */
+	UPROPERTY(Config)
+	float CameraArmLength = 2000.f;
+
+	/* Pitch of the camera boom in degrees */
+	UPROPERTY(Config)
+	float CameraPitch = -55.f;
+
+	/* Yaw of the camera boom in degrees, fixed in world space */
+	UPROPERTY(Config)
+	float CameraYaw = -90.f;
+
+	/* Horizontal field of view of the camera in degrees */
+	UPROPERTY(Config)
+	float CameraFieldOfView = 90.f;
+
+	/* Widest aspect ratio supported by the game */
+	UPROPERTY(Config)
+	float CameraAspectRatio = 16.f / 9.f;
+
+	/* Distance added to the camera footprint so actors are replicated before they enter the screen */
+	UPROPERTY(Config)
+	float RelevancyMargin = 500.f;
+
+	/* Distance added to the margin for firing characters, so projectiles flying into the screen are seen */
+	UPROPERTY(Config)
+	float FireEventMargin = 1500.f;
+
+	/* Return the ground area seen by the camera */
+	const FZoneProjectViewFootprint& GetViewFootprint() const { return ViewFootprint; }
+
+protected:
+
+	/* Grid of the spatialized actors */
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_GridSpatialization2D> GridNode;
+
+	/* Actors relevant to every connection */
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_ActorList> AlwaysRelevantNode;
+
+	/* Pooled characters, out of the spatial hash while dormant. Their channels stay open until they are reused */
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_ActorList> DormantCharacterNode;
+
+	/* Routing policy by class */
+	TClassMap<EZoneProjectRepNodeMapping> ClassRepNodePolicies;
+
+	/* Ground area seen by the camera */
+	FZoneProjectViewFootprint ViewFootprint;
+
+	/* Return the routing policy of the class */
+	EZoneProjectRepNodeMapping GetMappingPolicy(const UClass* Class);
+
+	/* Move a character in or out of the dormant character node */
+	void OnCharacterDormancyChanged(FActorRepListType Actor, FGlobalActorReplicationInfo& GlobalInfo, ENetDormancy NewValue, ENetDormancy OldValue);
+
+	/* Compute the ground area seen by the camera from the camera settings */
+	FZoneProjectViewFootprint ComputeViewFootprint() const;
+};
+
+/**
+ * Camera Footprint node. Gathers the characters and drop items inside the ground area seen by the viewers of the connection
+ */
+UCLASS()
+class ZONEPROJECT_API UZoneProjectReplicationGraphNode_CameraFootprint : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Actors are gathered from the spatial hash, not added to the node */
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override {}
+
+	/* Actors are gathered from the spatial hash, not added to the node */
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override { return false; }
+
+	/* Gather the actors inside the camera footprint of the connection */
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+protected:
+
+	/* Actors inside the camera footprint */
+	FActorRepListRefView FootprintActors;
+
+	/* Actors found by the spatial hash query, reused between frames */
+	TArray<AActor*> QueryActors;
+};
+
+/**
+ * Always Relevant For Connection node. Adds the pawn of the connection and its weapon to the controller and view target
+ */
+UCLASS()
+class ZONEPROJECT_API UZoneProjectReplicationGraphNode_AlwaysRelevant_ForConnection : public UReplicationGraphNode_AlwaysRelevant_ForConnection
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Gather the actors always relevant to the connection */
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+protected:
+
+	/* Pawns and weapons of the viewers of the connection */
+	FActorRepListRefView PawnActors;
+};
@@ -0,0 +1,272 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Rolling Statistics class. Keeps the latest samples in a fixed-capacity ring buffer allocated once by Init, and answers
+ * the mean and variance in O(1) from running sums, the minimum and maximum in O(1) from monotonic deques of the window,
+ * and percentiles in O(n) by selection in a preallocated scratch buffer
+ */
+template<typename T>
+class TRollingStatistics
+{
+public:
+
+	/* Class constructor */
+	explicit TRollingStatistics(const int32 InCapacity = 0)
+	{
+		Init(InCapacity);
+	}
+
+	/* Allocate the buffers for @InCapacity samples and clear them */
+	void Init(const int32 InCapacity)
+	{
+		Capacity = FMath::Max(InCapacity, 0);
+
+		Samples.SetNumZeroed(Capacity);
+		MinQueue.SetNumZeroed(Capacity);
+		MaxQueue.SetNumZeroed(Capacity);
+		Scratch.Reset(Capacity);
+
+		Reset();
+	}
+
+	/* Remove all samples, keeping the buffers */
+	void Reset()
+	{
+		Head = 0;
+		Count = 0;
+		Sequence = 0;
+
+		Mean = 0.0;
+		SquaredDeviations = 0.0;
+		UpdatesSinceRecompute = 0;
+
+		MinHead = MinCount = 0;
+		MaxHead = MaxCount = 0;
+	}
+
+	/* Add the newest sample, replacing the oldest one when the buffer is full */
+	void Add(const T Value)
+	{
+		if (Capacity == 0) return;
+
+		const double NewValue = static_cast<double>(Value);
+
+		if (Count == Capacity)
+		{
+			// Remove the oldest sample from the running sums before it is overwritten
+
+			const double OldValue = static_cast<double>(Samples[Head]);
+			const double OldMean = Mean;
+
+			if (Count == 1)
+			{
+				Mean = SquaredDeviations = 0.0;
+			}
+			else
+			{
+				Mean = (OldMean * Count - OldValue) / (Count - 1);
+				SquaredDeviations -= (OldValue - OldMean) * (OldValue - Mean);
+			}
+
+			--Count;
+		}
+
+		Samples[Head] = Value;
+		Head = (Head + 1) % Capacity;
+		++Count;
+
+		// Welford update of the mean and the sum of squared deviations
+
+		const double Delta = NewValue - Mean;
+		Mean += Delta / Count;
+		SquaredDeviations += Delta * (NewValue - Mean);
+
+		// Removing samples accumulates rounding errors, recompute the sums from the window once per capacity
+
+		if (++UpdatesSinceRecompute >= Capacity) RecomputeMoments();
+
+		PushMonotonic(MinQueue, MinHead, MinCount, Value, [](const T A, const T B) { return A <= B; });
+		PushMonotonic(MaxQueue, MaxHead, MaxCount, Value, [](const T A, const T B) { return A >= B; });
+
+		++Sequence;
+	}
+
+	/* Return the number of samples */
+	int32 Num() const { return Count; }
+
+	/* Return the maximum number of samples */
+	int32 GetCapacity() const { return Capacity; }
+
+	/* Check whether the buffer holds no samples */
+	bool IsEmpty() const { return Count == 0; }
+
+	/* Check whether the next sample replaces the oldest one */
+	bool IsFull() const { return Count == Capacity && Capacity > 0; }
+
+	/* Return the sample @Age samples older than the newest one */
+	T operator[](const int32 Age) const
+	{
+		check(Age >= 0 && Age < Count);
+		return Samples[(Head - 1 - Age + Capacity) % Capacity];
+	}
+
+	/* Return the newest sample */
+	T Last() const { return (*this)[0]; }
+
+	/* Call @Visitor for every sample from the newest to the oldest */
+	template<typename FunctorType>
+	void ForEach(FunctorType&& Visitor) const
+	{
+		for (int32 Age = 0; Age < Count; ++Age) Visitor((*this)[Age]);
+	}
+
+	/* Return the mean of the samples */
+	double GetMean() const { return Mean; }
+
+	/* Return the population variance of the samples */
+	double GetVariance() const { return Count > 0 ? FMath::Max(SquaredDeviations / Count, 0.0) : 0.0; }
+
+	/* Return the population standard deviation of the samples */
+	double GetStandardDeviation() const { return FMath::Sqrt(GetVariance()); }
+
+	/* Return the smallest sample */
+	T GetMin() const { return MinCount > 0 ? Samples[MinQueue[MinHead] % Capacity] : T(); }
+
+	/* Return the largest sample */
+	T GetMax() const { return MaxCount > 0 ? Samples[MaxQueue[MaxHead] % Capacity] : T(); }
+
+	/* Return the @Percentile (0..1) of the samples, linearly interpolated between the closest ranks */
+	double GetPercentile(const double Percentile) const
+	{
+		if (Count == 0) return 0.0;
+
+		Scratch.Reset();
+		for (int32 Index = 0; Index < Count; ++Index) Scratch.Add(Samples[Index]);
+
+		const double Rank = FMath::Clamp(Percentile, 0.0, 1.0) * (Count - 1);
+		const int32 Lower = FMath::FloorToInt32(Rank);
+		const int32 Upper = FMath::Min(Lower + 1, Count - 1);
+
+		const double LowerValue = static_cast<double>(Select(Lower));
+
+		// Everything above the lower rank is after it, the next rank is the smallest of them
+
+		double UpperValue = LowerValue;
+
+		if (Upper != Lower)
+		{
+			UpperValue = static_cast<double>(Scratch[Upper]);
+			for (int32 Index = Upper + 1; Index < Count; ++Index) UpperValue = FMath::Min(UpperValue, static_cast<double>(Scratch[Index]));
+		}
+
+		return FMath::Lerp(LowerValue, UpperValue, Rank - Lower);
+	}
+
+protected:
+
+	/* Samples written in a circle, the slot of sequence number S is S % Capacity */
+	TArray<T> Samples;
+
+	/* Scratch buffer of the percentile selection */
+	mutable TArray<T> Scratch;
+
+	/* Sequence numbers of the candidates for the minimum and the maximum, in deques stored in circles */
+	TArray<uint64> MinQueue;
+	TArray<uint64> MaxQueue;
+
+	/* Front and length of the deques */
+	int32 MinHead = 0;
+	int32 MinCount = 0;
+	int32 MaxHead = 0;
+	int32 MaxCount = 0;
+
+	/* Maximum number of samples */
+	int32 Capacity = 0;
+
+	/* Slot of the next sample */
+	int32 Head = 0;
+
+	/* Number of samples */
+	int32 Count = 0;
+
+	/* Sequence number of the next sample */
+	uint64 Sequence = 0;
+
+	/* Running mean and sum of squared deviations from it */
+	double Mean = 0.0;
+	double SquaredDeviations = 0.0;
+
+	/* Number of samples added since the sums were recomputed */
+	int32 UpdatesSinceRecompute = 0;
+
+	/* Recompute the running sums from the samples */
+	void RecomputeMoments()
+	{
+		UpdatesSinceRecompute = 0;
+
+		double Sum = 0.0;
+		for (int32 Index = 0; Index < Count; ++Index) Sum += static_cast<double>(Samples[Index]);
+
+		Mean = Count > 0 ? Sum / Count : 0.0;
+
+		SquaredDeviations = 0.0;
+		for (int32 Index = 0; Index < Count; ++Index) SquaredDeviations += FMath::Square(static_cast<double>(Samples[Index]) - Mean);
+	}
+
+	/* Add the newest sample to a monotonic deque. Candidates that can never be the extreme again are popped from the back */
+	template<typename PredicateType>
+	void PushMonotonic(TArray<uint64>& Queue, int32& QueueHead, int32& QueueCount, const T Value, PredicateType Dominates)
+	{
+		// The front leaves the window when its slot is overwritten
+
+		if (QueueCount > 0 && Queue[QueueHead] + Capacity <= Sequence)
+		{
+			QueueHead = (QueueHead + 1) % Capacity;
+			--QueueCount;
+		}
+
+		while (QueueCount > 0)
+		{
+			const int32 Back = (QueueHead + QueueCount - 1) % Capacity;
+			if (!Dominates(Value, Samples[Queue[Back] % Capacity])) break;
+
+			--QueueCount;
+		}
+
+		Queue[(QueueHead + QueueCount) % Capacity] = Sequence;
+		++QueueCount;
+	}
+
+	/* Partially sort the scratch buffer so the element of rank @Rank is in place and return it (Hoare's selection) */
+	T Select(const int32 Rank) const
+	{
+		int32 Left = 0;
+		int32 Right = Scratch.Num() - 1;
+
+		while (Left < Right)
+		{
+			const T Pivot = Scratch[Left + (Right - Left) / 2];
+
+			int32 I = Left;
+			int32 J = Right;
+
+			while (I <= J)
+			{
+				while (Scratch[I] < Pivot) ++I;
+				while (Pivot < Scratch[J]) --J;
+
+				if (I <= J) Swap(Scratch[I++], Scratch[J--]);
+			}
+
+			if (Rank <= J) Right = J;
+			else if (Rank >= I) Left = I;
+			else break;
+		}
+
+		return Scratch[Rank];
+	}
+};
@@ -0,0 +1,101 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZoneProjectTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ZoneProjectSignificanceSubsystem.generated.h"
+
+/**
+ * Significance state of a registered actor
+ */
+struct FZoneProjectSignificanceEntry
+{
+	/* Registered actor */
+	TWeakObjectPtr<AActor> Actor;
+
+	/* Key of the actor in the index, still valid after the actor is destroyed */
+	TObjectKey<AActor> Key;
+
+	/* Index of the bucket currently applied to the actor */
+	int32 Bucket = INDEX_NONE;
+};
+
+/**
+ * Significance Subsystem class. Scores registered actors by the distance to the nearest player view
+ * and throttles their actor, animation, movement and AI ticks in buckets, re-evaluating a limited number of actors per frame
+ */
+UCLASS(Config = Game)
+class ZONEPROJECT_API UZoneProjectSignificanceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Called every frame */
+	virtual void Tick(float DeltaTime) override;
+
+	/* Return the stat id used to profile the tick */
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	/* Only game worlds throttle ticks */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+public:
+
+	/* Buckets ordered by increasing distance. Actors beyond the last bucket use the last one */
+	UPROPERTY(Config)
+	TArray<FSignificanceBucket> Buckets;
+
+	/* Extra distance an actor must move past a bucket edge before it is demoted, to avoid flapping */
+	UPROPERTY(Config)
+	float HysteresisDistance = 200.f;
+
+	/* Demote actors that have not been rendered recently by one bucket (clients only) */
+	UPROPERTY(Config)
+	bool bDemoteNotRendered = true;
+
+	/* Maximum number of actors re-evaluated per frame */
+	UPROPERTY(Config)
+	int32 MaxUpdatesPerFrame = 32;
+
+protected:
+
+	/* All registered actors */
+	TArray<FZoneProjectSignificanceEntry> Entries;
+
+	/* Entry index by actor */
+	TMap<TObjectKey<AActor>, int32> EntryIndices;
+
+	/* Index of the next entry to re-evaluate */
+	int32 Cursor = 0;
+
+	/* Player view locations gathered once per frame */
+	TArray<FVector> ViewLocations;
+
+	/* Gather the view location of every local or remote player */
+	void GatherViewLocations();
+
+	/* Find the bucket of the actor based on its current bucket and distance */
+	int32 EvaluateBucket(const AActor* Actor, const int32 CurrentBucket) const;
+
+	/* Apply the tick intervals of the bucket to the actor and its components */
+	static void ApplyBucket(AActor* Actor, const FSignificanceBucket& Bucket);
+
+public:
+
+	/* Start throttling the actor by its significance */
+	void RegisterActor(AActor* Actor);
+
+	/* Stop throttling the actor and restore full tick rate */
+	void UnregisterActor(AActor* Actor);
+
+	/* Return the bucket currently applied to the actor (INDEX_NONE if not registered or not evaluated yet) */
+	int32 GetActorBucket(const AActor* Actor) const;
+
+	/* Print the number of actors in every bucket to the log */
+	void DumpStats() const;
+};
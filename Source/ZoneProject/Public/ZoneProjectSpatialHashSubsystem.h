@@ -0,0 +1,122 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZoneProject/ZoneProject.h"
+#include "ZoneProjectTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ZoneProjectSpatialHashSubsystem.generated.h"
+
+/**
+ * Actor indexed by the spatial hash
+ */
+struct FZoneProjectSpatialEntry
+{
+	/* Indexed actor */
+	TWeakObjectPtr<AActor> Actor;
+
+	/* Key of the actor in the index, still valid after the actor is destroyed */
+	TObjectKey<AActor> Key;
+
+	/* Location when the entry was last updated */
+	FVector Location = FVector::ZeroVector;
+
+	/* Radius added to the query distance */
+	float Radius = 0.f;
+
+	/* Key of the cell the entry is stored in */
+	uint64 Cell = 0;
+
+	/* Category used to filter queries */
+	ESpatialCategory Category = ESpatialCategory::None;
+
+	/* Indicates whether the entry never moves and is skipped by the per-frame update */
+	bool bStatic = false;
+};
+
+/**
+ * Spatial Hash Subsystem class. Indexes characters, drop items and projectiles in a uniform 2D grid,
+ * updated incrementally as they move, and answers radius, box and nearest neighbor queries without the physics scene
+ */
+UCLASS(Config = Game)
+class ZONEPROJECT_API UZoneProjectSpatialHashSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Called every frame */
+	virtual void Tick(float DeltaTime) override;
+
+	/* Return the stat id used to profile the tick */
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	/* Only the server queries the index, clients never create it */
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	/* Only game worlds index actors */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+public:
+
+	/* Size of a grid cell. Queries are fastest when their radius is close to the cell size */
+	UPROPERTY(Config)
+	float CellSize = 500.f;
+
+protected:
+
+	/* All indexed actors. Indices are stable, so cells can refer to them */
+	TSparseArray<FZoneProjectSpatialEntry> Entries;
+
+	/* Entry index by actor */
+	TMap<TObjectKey<AActor>, int32> EntryIndices;
+
+	/* Entry indices by cell key */
+	TMap<uint64, TArray<int32>> Cells;
+
+	/* Return the cell coordinates of the location */
+	FIntPoint GetCellCoords(const FVector& Location) const;
+
+	/* Return the key of the cell at the specified coordinates */
+	static uint64 GetCellKey(const FIntPoint& Coords);
+
+	/* Move the entry to the cell of its new location */
+	void MoveEntry(const int32 Index, const FVector& Location);
+
+	/* Remove the entry from its cell */
+	void RemoveFromCell(const int32 Index);
+
+	/* Call @Visitor for every live entry of the categories in the cells overlapping the box */
+	void ForEachInCells(const FIntPoint& Min, const FIntPoint& Max, const ESpatialCategory Categories,
+		TFunctionRef<void(const FZoneProjectSpatialEntry&)> Visitor) const;
+
+public:
+
+	/* Start indexing the actor */
+	void RegisterActor(AActor* Actor, const ESpatialCategory Category, const float Radius = 0.f, const bool bStatic = false);
+
+	/* Stop indexing the actor */
+	void UnregisterActor(AActor* Actor);
+
+	/* Update the location of the actor immediately instead of waiting for the next frame */
+	void UpdateActor(AActor* Actor);
+
+	/* Find all actors of the categories within the radius of the center */
+	void QueryRadius(const FVector& Center, const float Radius, const ESpatialCategory Categories, TArray<AActor*>& OutActors) const;
+
+	/* Find all actors of the categories inside the 2D box */
+	void QueryBox(const FBox2D& Box, const ESpatialCategory Categories, TArray<AActor*>& OutActors) const;
+
+	/* Find up to @Count actors of the categories nearest to the center within the maximum radius, sorted by distance */
+	void QueryNearest(const FVector& Center, const int32 Count, const float MaxRadius, const ESpatialCategory Categories,
+		TArray<AActor*>& OutActors, TFunctionRef<bool(const AActor*)> Filter = [](const AActor*) { return true; }) const;
+
+	/* Check whether any actor of the categories is within the radius of the center */
+	bool AnyInRadius(const FVector& Center, const float Radius, const ESpatialCategory Categories) const;
+
+	/* Return the number of indexed actors */
+	int32 GetNumEntries() const { return Entries.Num(); }
+};
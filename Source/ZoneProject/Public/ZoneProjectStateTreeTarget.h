@@ -0,0 +1,99 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "StateTreeConditionBase.h"
+#include "StateTreeEvaluatorBase.h"
+#include "ZoneProjectStateTreeTarget.generated.h"
+
+/**
+ * Target evaluator instance data
+ */
+USTRUCT()
+struct ZONEPROJECT_API FZoneProjectTargetEvaluatorInstanceData
+{
+	GENERATED_BODY()
+
+	/* Pawn querying the target */
+	UPROPERTY(EditAnywhere, Category = "Context")
+	TObjectPtr<AActor> Actor = nullptr;
+
+	/* Nearest alive player */
+	UPROPERTY(EditAnywhere, Category = "Output")
+	TObjectPtr<AActor> Target = nullptr;
+
+	/* Indicates whether there is a target */
+	UPROPERTY(EditAnywhere, Category = "Output")
+	bool bHasTarget = false;
+
+	/* Cached horizontal distance to the target */
+	UPROPERTY(EditAnywhere, Category = "Output")
+	float Distance = 0.f;
+
+	/* Cached visibility of the target */
+	UPROPERTY(EditAnywhere, Category = "Output")
+	bool bHasLineOfSight = false;
+};
+
+/**
+ * Target evaluator. Exposes the cached result of the target subsystem to the tree
+ */
+USTRUCT(Meta = (DisplayName = "Target", Category = "ZoneProject"))
+struct ZONEPROJECT_API FZoneProjectTargetEvaluator : public FStateTreeEvaluatorCommonBase
+{
+	GENERATED_BODY()
+
+	using FInstanceDataType = FZoneProjectTargetEvaluatorInstanceData;
+
+	/* Return the instance data type */
+	virtual const UStruct* GetInstanceDataType() const override { return FInstanceDataType::StaticStruct(); }
+
+	/* Called every tick */
+	virtual void Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const override;
+
+	/* Called when the tree stops */
+	virtual void TreeStop(FStateTreeExecutionContext& Context) const override;
+};
+
+/**
+ * Target In Range condition instance data
+ */
+USTRUCT()
+struct ZONEPROJECT_API FZoneProjectTargetInRangeConditionInstanceData
+{
+	GENERATED_BODY()
+
+	/* Pawn querying the target */
+	UPROPERTY(EditAnywhere, Category = "Context")
+	TObjectPtr<AActor> Actor = nullptr;
+
+	/* Maximum distance to the target */
+	UPROPERTY(EditAnywhere, Category = "Parameter", Meta = (ClampMin = "0", UIMin = "0", ForceUnits = "cm"))
+	float MaxDistance = 1200.f;
+
+	/* Also require the target to be visible */
+	UPROPERTY(EditAnywhere, Category = "Parameter")
+	bool bRequireLineOfSight = false;
+};
+
+/**
+ * Target In Range condition. Tests the cached target distance and visibility
+ */
+USTRUCT(Meta = (DisplayName = "Target In Range", Category = "ZoneProject"))
+struct ZONEPROJECT_API FZoneProjectTargetInRangeCondition : public FStateTreeConditionCommonBase
+{
+	GENERATED_BODY()
+
+	using FInstanceDataType = FZoneProjectTargetInRangeConditionInstanceData;
+
+	/* Return the instance data type */
+	virtual const UStruct* GetInstanceDataType() const override { return FInstanceDataType::StaticStruct(); }
+
+	/* Test the condition */
+	virtual bool TestCondition(FStateTreeExecutionContext& Context) const override;
+
+	/* Invert the result */
+	UPROPERTY(EditAnywhere, Category = "Condition")
+	bool bInvert = false;
+};
@@ -0,0 +1,134 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "StateTreeTaskBase.h"
+#include "ZoneProjectStateTreeTasks.generated.h"
+
+class AAIController;
+
+/**
+ * Move To Target task instance data
+ */
+USTRUCT()
+struct ZONEPROJECT_API FZoneProjectMoveToTargetTaskInstanceData
+{
+	GENERATED_BODY()
+
+	/* Controller of the moving pawn */
+	UPROPERTY(EditAnywhere, Category = "Context")
+	TObjectPtr<AAIController> AIController = nullptr;
+
+	/* Distance to the target at which the move succeeds */
+	UPROPERTY(EditAnywhere, Category = "Parameter", Meta = (ClampMin = "0", UIMin = "0", ForceUnits = "cm"))
+	float AcceptanceRadius = 150.f;
+
+	/* Target of the current move request */
+	UPROPERTY()
+	TObjectPtr<AActor> MoveTarget = nullptr;
+};
+
+/**
+ * Move To Target task. Follows the nearest player found by the target subsystem
+ */
+USTRUCT(Meta = (DisplayName = "Move To Target", Category = "ZoneProject"))
+struct ZONEPROJECT_API FZoneProjectMoveToTargetTask : public FStateTreeTaskCommonBase
+{
+	GENERATED_BODY()
+
+	using FInstanceDataType = FZoneProjectMoveToTargetTaskInstanceData;
+
+	/* Return the instance data type */
+	virtual const UStruct* GetInstanceDataType() const override { return FInstanceDataType::StaticStruct(); }
+
+	/* Called when the state becomes active */
+	virtual EStateTreeRunStatus EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
+
+	/* Called every tick while the state is active */
+	virtual EStateTreeRunStatus Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const override;
+
+	/* Called when the state becomes inactive */
+	virtual void ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
+};
+
+/**
+ * Attack Target task instance data
+ */
+USTRUCT()
+struct ZONEPROJECT_API FZoneProjectAttackTargetTaskInstanceData
+{
+	GENERATED_BODY()
+
+	/* Controller of the attacking pawn */
+	UPROPERTY(EditAnywhere, Category = "Context")
+	TObjectPtr<AAIController> AIController = nullptr;
+
+	/* Maximum distance to the target to keep firing */
+	UPROPERTY(EditAnywhere, Category = "Parameter", Meta = (ClampMin = "0", UIMin = "0", ForceUnits = "cm"))
+	float AttackRange = 1200.f;
+
+	/* Stop firing when the target is not visible */
+	UPROPERTY(EditAnywhere, Category = "Parameter")
+	bool bRequireLineOfSight = true;
+};
+
+/**
+ * Attack Target task. Aims at the nearest player and holds the trigger while it is in range
+ */
+USTRUCT(Meta = (DisplayName = "Attack Target", Category = "ZoneProject"))
+struct ZONEPROJECT_API FZoneProjectAttackTargetTask : public FStateTreeTaskCommonBase
+{
+	GENERATED_BODY()
+
+	using FInstanceDataType = FZoneProjectAttackTargetTaskInstanceData;
+
+	/* Return the instance data type */
+	virtual const UStruct* GetInstanceDataType() const override { return FInstanceDataType::StaticStruct(); }
+
+	/* Called when the state becomes active */
+	virtual EStateTreeRunStatus EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
+
+	/* Called every tick while the state is active */
+	virtual EStateTreeRunStatus Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const override;
+
+	/* Called when the state becomes inactive */
+	virtual void ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
+};
+
+/**
+ * Turn To Target task instance data
+ */
+USTRUCT()
+struct ZONEPROJECT_API FZoneProjectTurnToTargetTaskInstanceData
+{
+	GENERATED_BODY()
+
+	/* Controller of the turning pawn */
+	UPROPERTY(EditAnywhere, Category = "Context")
+	TObjectPtr<AAIController> AIController = nullptr;
+
+	/* Angle to the target at which the turn succeeds */
+	UPROPERTY(EditAnywhere, Category = "Parameter", Meta = (ClampMin = "0", UIMin = "0", ClampMax = "180", UIMax = "180", ForceUnits = "deg"))
+	float AcceptableAngle = 10.f;
+};
+
+/**
+ * Turn To Target task. Focuses the nearest player and succeeds once the pawn faces it
+ */
+USTRUCT(Meta = (DisplayName = "Turn To Target", Category = "ZoneProject"))
+struct ZONEPROJECT_API FZoneProjectTurnToTargetTask : public FStateTreeTaskCommonBase
+{
+	GENERATED_BODY()
+
+	using FInstanceDataType = FZoneProjectTurnToTargetTaskInstanceData;
+
+	/* Return the instance data type */
+	virtual const UStruct* GetInstanceDataType() const override { return FInstanceDataType::StaticStruct(); }
+
+	/* Called when the state becomes active */
+	virtual EStateTreeRunStatus EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
+
+	/* Called every tick while the state is active */
+	virtual EStateTreeRunStatus Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const override;
+};
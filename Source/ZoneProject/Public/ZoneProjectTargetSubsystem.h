@@ -0,0 +1,91 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZoneProjectTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ZoneProjectTargetSubsystem.generated.h"
+
+/**
+ * Cached target query result of a single querier
+ */
+struct FZoneProjectTargetInfo
+{
+	/* Querier the result belongs to */
+	TWeakObjectPtr<AActor> Querier;
+
+	/* Key of the querier in the index, still valid after the querier is destroyed */
+	TObjectKey<AActor> Key;
+
+	/* Nearest alive player pawn */
+	TWeakObjectPtr<APawn> Target;
+
+	/* Horizontal distance to the target when the result was updated */
+	float Distance = 0.f;
+
+	/* Indicates whether the target was visible from the querier when the result was updated */
+	bool bHasLineOfSight = false;
+
+	/* World time when the result was updated (negative if never) */
+	double UpdateTime = -1.0;
+};
+
+/**
+ * Target Subsystem class. Shared target query service for AI: finds the nearest player and checks the line of sight
+ * for a limited number of queriers per frame, so every enemy reads a cached result instead of querying the world itself (server only)
+ */
+UCLASS(Config = Game)
+class ZONEPROJECT_API UZoneProjectTargetSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Called every frame */
+	virtual void Tick(float DeltaTime) override;
+
+	/* Return the stat id used to profile the tick */
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	/* Only game worlds query targets */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+public:
+
+	/* Maximum number of queriers updated per frame */
+	UPROPERTY(Config)
+	int32 MaxQueriesPerFrame = 24;
+
+	/* Maximum distance at which a player can be targeted */
+	UPROPERTY(Config)
+	float MaxTargetDistance = 5000.f;
+
+	/* Trace channel used for the line of sight checks */
+	UPROPERTY(Config)
+	TEnumAsByte<ECollisionChannel> LineOfSightChannel = ECC_Visibility;
+
+protected:
+
+	/* Cached results of all queriers */
+	TArray<FZoneProjectTargetInfo> Results;
+
+	/* Result index by querier */
+	TMap<TObjectKey<AActor>, int32> ResultIndices;
+
+	/* Index of the next result to update */
+	int32 Cursor = 0;
+
+	/* Find the nearest player and check the line of sight for the querier */
+	void UpdateResult(FZoneProjectTargetInfo& Result) const;
+
+public:
+
+	/* Return a copy of the cached result of the querier, registering it on the first call */
+	FZoneProjectTargetInfo GetTargetInfo(AActor* Querier);
+
+	/* Stop updating the querier */
+	void UnregisterQuerier(AActor* Querier);
+};
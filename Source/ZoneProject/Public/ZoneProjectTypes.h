@@ -10,97 +10,270 @@
  */
 
 USTRUCT(BlueprintType)
-struct ZONEPROJECT_API FValueHistory
+struct ZONEPROJECT_API FDropItemProbability
 {
 	GENERATED_USTRUCT_BODY()
+ 
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	TSoftClassPtr<class AZoneProjectDropItem> ItemClass;
 
-protected:
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (ClampMin = "0", UIMin = "0", ClampMax = "1", UIMax = "1"))
+	float Value = 1.f;
+};
 
-	/* List of values */
-	TArray<float> Values;
+USTRUCT(BlueprintType)
+struct ZONEPROJECT_API FProjectilePoolStats
+{
+	GENERATED_USTRUCT_BODY()
 
-	/* Maximum number of values in the list */
-	int32 MaxCount = 2;
+	/* Number of projectiles served from the pool without spawning */
+	UPROPERTY(BlueprintReadOnly)
+	int32 Hits = 0;
 
-public:
+	/* Number of projectiles that had to be spawned because the pool was empty */
+	UPROPERTY(BlueprintReadOnly)
+	int32 Misses = 0;
 
-	/* Constructor */
-	explicit FValueHistory(const int32 InMaxCount = 2)
-	{ 
-		Init(InMaxCount);
-	}
+	/* Number of in-flight projectiles forcibly recycled by the overflow policy */
+	UPROPERTY(BlueprintReadOnly)
+	int32 Recycled = 0;
 
-	/* Initialize the history */
-	void Init(const int32 InMaxCount = 2)
-	{
-		Values.Empty();
-		MaxCount = FMath::Clamp(InMaxCount, 2, 255);
-	}
+	/* Number of requests rejected by the overflow policy */
+	UPROPERTY(BlueprintReadOnly)
+	int32 Rejected = 0;
 
-	/* Clear the list */
-	void Clear()
-	{
-		Values.Empty();
-	}
+	/* Highest number of simultaneously active projectiles */
+	UPROPERTY(BlueprintReadOnly)
+	int32 PeakActive = 0;
+};
 
-	/* Add a value to the beginning of the list */
-	void Insert(const float Value)
-	{
-		Values.Insert(Value, 0);
-		while (Values.Num() > MaxCount) Values.RemoveAt(MaxCount);
-	}
+USTRUCT(BlueprintType)
+struct ZONEPROJECT_API FSignificanceBucket
+{
+	GENERATED_USTRUCT_BODY()
 
-	/* Add a value to the end of the list */
-	void Add(const float Value)
-	{
-		if (Values.Num() < MaxCount) Values.Add(Value);
-	}
+	/* Distance to the nearest player view up to which actors fall into this bucket */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Meta = (ClampMin = "0", UIMin = "0", ForceUnits = "cm"))
+	float MaxDistance = 0.f;
 
-	/* Return the list of values */
-	TArray<float> GetValues() const
-	{
-		return Values;
-	}
+	/* Tick interval of the actor and its AI controller (0 ticks every frame) */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Meta = (ClampMin = "0", UIMin = "0", ForceUnits = "s"))
+	float TickInterval = 0.f;
 
-	/* Return the maximum count of values in the list */
-	int32 GetMaxCount() const
-	{
-		return MaxCount;
-	}
+	/* Tick interval of the skeletal mesh, which drives the animation update rate */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Meta = (ClampMin = "0", UIMin = "0", ForceUnits = "s"))
+	float AnimationTickInterval = 0.f;
+
+	/* Tick interval of the movement component */
+	UPROPERTY(BlueprintReadOnly, EditAnywhere, Meta = (ClampMin = "0", UIMin = "0", ForceUnits = "s"))
+	float MovementTickInterval = 0.f;
+};
+
+USTRUCT(BlueprintType)
+struct ZONEPROJECT_API FWeaponFireState
+{
+	GENERATED_USTRUCT_BODY()
+
+	/* Indicates whether the trigger is held */
+	UPROPERTY(BlueprintReadOnly)
+	bool bFiring = false;
+
+	/* Incremented on every burst so identical consecutive bursts still replicate */
+	UPROPERTY()
+	uint8 BurstId = 0;
+
+	/* Server time when the burst started */
+	UPROPERTY(BlueprintReadOnly)
+	float StartTime = 0.f;
+
+	/* Random seed used to reproduce the shots of the burst */
+	UPROPERTY(BlueprintReadOnly)
+	int32 Seed = 0;
 
-	/* Find the minimum value in the list */
-	float Min() const
+	/* Aim yaw at the start of the burst, compressed to 16 bits */
+	UPROPERTY()
+	uint16 AimYaw = 0;
+
+	/* Serialize only the fields relevant to the current state */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
 	{
-		if (Values.Num() == 0) return 0.f;
-		return FMath::Min(Values);
+		uint8 bFiringBit = bFiring ? 1 : 0;
+		Ar.SerializeBits(&bFiringBit, 1);
+		bFiring = bFiringBit != 0;
+
+		Ar << BurstId;
+
+		if (bFiring)
+		{
+			uint16 Seed16 = static_cast<uint16>(Seed);
+
+			Ar << StartTime;
+			Ar << Seed16;
+			Ar << AimYaw;
+
+			Seed = Seed16;
+		}
+
+		bOutSuccess = true;
+		return true;
 	}
+};
 
-	/* Find the maximum value in the list */
-	float Max() const
+template<>
+struct TStructOpsTypeTraits<FWeaponFireState> : public TStructOpsTypeTraitsBase2<FWeaponFireState>
+{
+	enum
 	{
-		if (Values.Num() == 0) return 0.f;
-		return FMath::Max(Values);
-	}
+		WithNetSerializer = true
+	};
+};
+
+/**
+ * Health and maximum health of a character, replicated together in 26 bits with the health quantized to a fraction
+ */
+USTRUCT(BlueprintType)
+struct ZONEPROJECT_API FQuantizedHealth
+{
+	GENERATED_USTRUCT_BODY()
+
+	/* Number of steps the health fraction is quantized to */
+	static constexpr uint32 HealthSteps = 1023;
+
+	/* Current health amount */
+	UPROPERTY(BlueprintReadOnly)
+	float Health = 0.f;
 
-	/* Calculate the average value of the list */
-	float Average() const
+	/* Maximum health amount */
+	UPROPERTY(BlueprintReadOnly)
+	float MaxHealth = 0.f;
+
+	/* Serialize the maximum health as a 16-bit whole number and the health as a 10-bit fraction of it */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
 	{
-		if (Values.Num() == 0) return 0.f;
+		uint16 MaxHealth16 = static_cast<uint16>(FMath::Clamp(FMath::RoundToInt32(MaxHealth), 0, static_cast<int32>(MAX_uint16)));
+		uint32 Fraction = MaxHealth > 0.f ? static_cast<uint32>(FMath::RoundToInt32(FMath::Clamp(Health / MaxHealth, 0.f, 1.f) * HealthSteps)) : 0;
+
+		// A wounded character never rounds down to zero health on clients
+
+		if (Health > 0.f && Fraction == 0) Fraction = 1;
 
-		float Sum = 0.f;
-		for (auto& Value : Values) Sum += Value;
-		return Sum / Values.Num();
+		Ar << MaxHealth16;
+		Ar.SerializeInt(Fraction, HealthSteps + 1);
+
+		if (Ar.IsLoading())
+		{
+			MaxHealth = MaxHealth16;
+			Health = MaxHealth * Fraction / HealthSteps;
+		}
+
+		bOutSuccess = true;
+		return true;
 	}
 };
 
+template<>
+struct TStructOpsTypeTraits<FQuantizedHealth> : public TStructOpsTypeTraitsBase2<FQuantizedHealth>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+/**
+ * Movement of a character replicated for a top-down game, where the height and vertical velocity rarely change
+ */
 USTRUCT(BlueprintType)
-struct ZONEPROJECT_API FDropItemProbability
+struct ZONEPROJECT_API FPlanarRepMovement
 {
 	GENERATED_USTRUCT_BODY()
- 
-	UPROPERTY(BlueprintReadWrite, EditAnywhere)
-	TSubclassOf<class AZoneProjectDropItem> ItemClass;
 
-	UPROPERTY(BlueprintReadWrite, EditAnywhere, Meta = (ClampMin = "0", UIMin = "0", ClampMax = "1", UIMax = "1"))
-	float Value = 1.f;
+	/* Number of bits of the position inside a grid cell at 1 cm precision (164 m cells) */
+	static constexpr int32 CellBits = 14;
+
+	/* Largest horizontal speed sent, at 1 cm/s precision */
+	static constexpr int32 MaxPlanarSpeed = 2047;
+
+	/* Location of the character */
+	UPROPERTY(BlueprintReadOnly)
+	FVector Location = FVector::ZeroVector;
+
+	/* Yaw of the character */
+	UPROPERTY(BlueprintReadOnly)
+	float Yaw = 0.f;
+
+	/* Velocity of the character */
+	UPROPERTY(BlueprintReadOnly)
+	FVector Velocity = FVector::ZeroVector;
+
+	/* Indicates whether the height and vertical velocity are sent, only while they change */
+	UPROPERTY(BlueprintReadOnly)
+	bool bHasZ = false;
+
+	/* Serialize the planar position as a grid cell and an offset inside it, the yaw in 16 bits and the planar velocity in 12 bits per axis */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+	{
+		for (int32 Axis = 0; Axis < 2; ++Axis)
+		{
+			const int32 Centimeters = FMath::RoundToInt32(Location[Axis]);
+
+			// Zigzag encoding keeps the cells around the origin small for both signs
+
+			int32 Cell = Centimeters >> CellBits;
+			uint32 ZigZagCell = static_cast<uint32>((Cell << 1) ^ (Cell >> 31));
+			uint32 Offset = static_cast<uint32>(Centimeters - Cell * (1 << CellBits));
+
+			Ar.SerializeIntPacked(ZigZagCell);
+			Ar.SerializeInt(Offset, 1 << CellBits);
+
+			int32 Speed = FMath::Clamp(FMath::RoundToInt32(Velocity[Axis]), -MaxPlanarSpeed, MaxPlanarSpeed);
+			uint32 BiasedSpeed = static_cast<uint32>(Speed + MaxPlanarSpeed);
+
+			Ar.SerializeInt(BiasedSpeed, 2 * MaxPlanarSpeed + 1);
+
+			if (Ar.IsLoading())
+			{
+				Cell = static_cast<int32>(ZigZagCell >> 1) ^ -static_cast<int32>(ZigZagCell & 1);
+
+				Location[Axis] = static_cast<double>(Cell) * (1 << CellBits) + Offset;
+				Velocity[Axis] = static_cast<double>(static_cast<int32>(BiasedSpeed) - MaxPlanarSpeed);
+			}
+		}
+
+		uint16 Yaw16 = FRotator::CompressAxisToShort(Yaw);
+		Ar << Yaw16;
+
+		uint8 bHasZBit = bHasZ ? 1 : 0;
+		Ar.SerializeBits(&bHasZBit, 1);
+
+		float Z = Location.Z;
+		float VelocityZ = Velocity.Z;
+
+		if (bHasZBit)
+		{
+			Ar << Z;
+			Ar << VelocityZ;
+		}
+
+		if (Ar.IsLoading())
+		{
+			Yaw = FRotator::DecompressAxisFromShort(Yaw16);
+			bHasZ = bHasZBit != 0;
+
+			Location.Z = Z;
+			Velocity.Z = bHasZ ? VelocityZ : 0.f;
+		}
+
+		bOutSuccess = true;
+		return true;
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FPlanarRepMovement> : public TStructOpsTypeTraitsBase2<FPlanarRepMovement>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
 };
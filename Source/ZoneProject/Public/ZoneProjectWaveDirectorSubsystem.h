@@ -0,0 +1,183 @@
+// Copyright Anton Romanov. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZoneProjectTypes.h"
+#include "AI/Navigation/NavigationTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ZoneProjectWaveDirectorSubsystem.generated.h"
+
+class AZoneProjectCharacter;
+class ANavigationData;
+
+/**
+ * Enemy waiting for a spawn point near its player
+ */
+struct FZoneProjectPendingSpawn
+{
+	/* Enemy class */
+	TSubclassOf<AZoneProjectCharacter> EnemyClass;
+
+	/* Player the enemy is spawned around, reassigned when the player leaves */
+	TWeakObjectPtr<APawn> Player;
+};
+
+/**
+ * Spawn point validated against the navmesh
+ */
+struct FZoneProjectSpawnPoint
+{
+	/* Location on the navmesh */
+	FVector Location = FVector::ZeroVector;
+
+	/* Time an enemy was last spawned at the point */
+	double LastSpawnTime = -UE_BIG_NUMBER;
+
+	/* Navmesh generation the point was last validated in */
+	uint32 NavGeneration = 0;
+};
+
+/**
+ * Wave Director Subsystem class. Spreads the enemies of every wave across all players and spawns them at points
+ * validated by asynchronous navmesh path queries towards the player. Valid points are cached by region and reused
+ * by later waves, and a per-frame budget spreads large waves over several frames (server only)
+ */
+UCLASS(Config = Game)
+class ZONEPROJECT_API UZoneProjectWaveDirectorSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/* Called when the world has begun play */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/* Called when the subsystem is destroyed */
+	virtual void Deinitialize() override;
+
+	/* Called every frame */
+	virtual void Tick(float DeltaTime) override;
+
+	/* Return the stat id used to profile the tick */
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	/* Only game worlds spawn waves */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+public:
+
+	/* Maximum number of enemies spawned per frame */
+	UPROPERTY(Config)
+	int32 MaxSpawnsPerFrame = 2;
+
+	/* Maximum number of pending enemies tried per frame, pending enemies without a point near their player are skipped */
+	UPROPERTY(Config)
+	int32 MaxSpawnAttemptsPerFrame = 8;
+
+	/* Maximum number of pending enemies, the rest of a wave is dropped */
+	UPROPERTY(Config)
+	int32 MaxPendingSpawns = 512;
+
+	/* Maximum number of path queries started per frame */
+	UPROPERTY(Config)
+	int32 MaxQueriesPerFrame = 4;
+
+	/* Maximum number of path queries running at once */
+	UPROPERTY(Config)
+	int32 MaxQueriesInFlight = 8;
+
+	/* Number of valid points around every player kept in the cache */
+	UPROPERTY(Config)
+	int32 MinPointsPerPlayer = 8;
+
+	/* Size of the regions points are cached by */
+	UPROPERTY(Config)
+	float RegionSize = 1000.f;
+
+	/* Maximum number of points cached per region */
+	UPROPERTY(Config)
+	int32 MaxPointsPerRegion = 8;
+
+	/* Accepted difference between the spawn distance and the distance from the player to a cached point */
+	UPROPERTY(Config)
+	float DistanceTolerance = 250.f;
+
+	/* Seconds before another enemy can spawn at the same point */
+	UPROPERTY(Config)
+	float PointCooldown = 3.f;
+
+protected:
+
+	/* Enemies waiting for a spawn point, in the order they are spawned */
+	TArray<FZoneProjectPendingSpawn> PendingSpawns;
+
+	/* Distance from the players to the spawn points, set by the last wave */
+	float SpawnDistance = 0.f;
+
+	/* Minimum distance from other characters to the spawn points, set by the last wave */
+	float SpawnClearance = 0.f;
+
+	/* Valid spawn points by region */
+	TMap<FIntPoint, TArray<FZoneProjectSpawnPoint>> RegionPoints;
+
+	/* Running path queries and the navmesh generation they were started in */
+	TMap<uint32, uint32> QueriesInFlight;
+
+	/* Number of times the navmesh was rebuilt. Points validated in an older generation are projected again before use */
+	uint32 NavGeneration = 0;
+
+	/* Player pawns gathered once per frame */
+	TArray<APawn*> Players;
+
+	/* Player whose points are topped up first in the next frame */
+	int32 NextQueryPlayer = 0;
+
+	/* Pending enemy tried first in the next frame */
+	int32 NextSpawn = 0;
+
+	/* Number of enemies spawned and queries that failed since the start */
+	int32 NumSpawned = 0;
+	int32 NumFailedQueries = 0;
+
+	/* Return the region containing the location */
+	FIntPoint GetRegion(const FVector& Location) const;
+
+	/* Return the number of cached points around the player at the spawn distance */
+	int32 CountPoints(const FVector& PlayerLocation) const;
+
+	/* Find a random cached point around the player at the spawn distance, clear of other characters and off cooldown.
+	 * Returns null if the picked point is no longer on the rebuilt navmesh, the point is dropped from the cache then */
+	FZoneProjectSpawnPoint* FindPoint(const FVector& PlayerLocation);
+
+	/* Return the number of cached points */
+	int32 GetNumPoints() const;
+
+	/* Spawn pending enemies within the frame budget */
+	void SpawnPending();
+
+	/* Start path queries from random points around the players short of cached points */
+	void QueryPoints();
+
+	/* Called when a path query has finished */
+	void OnPathQueryFinished(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
+
+	/* Mark the cached points for validation when the navmesh is rebuilt */
+	UFUNCTION()
+	void OnNavigationGenerated(ANavigationData* NavigationData);
+
+public:
+
+	/* Queue @CountPerPlayer enemies around every player at @Distance from them and @Clearance from other characters */
+	UFUNCTION(Category = "Enemy", BlueprintCallable)
+	void QueueWave(TSubclassOf<AZoneProjectCharacter> EnemyClass, int32 CountPerPlayer, float Distance, float Clearance);
+
+	/* Return the number of enemies waiting for a spawn point */
+	UFUNCTION(Category = "Enemy", BlueprintCallable)
+	int32 GetNumPending() const { return PendingSpawns.Num(); }
+
+	/* Print the pending enemies and the cached points to the log */
+	void DumpStats() const;
+};
@@ -2,7 +2,7 @@
 
 #pragma once
 
-#include "CoreMinimal.h"
+#include "ZoneProject/ZoneProject.h"
 #include "ZoneProjectTypes.h"
 #include "GameFramework/Actor.h"
 #include "ZoneProjectWeapon.generated.h"
@@ -29,6 +29,12 @@ public:
 	/* Called after initializing components */
 	virtual void PostInitializeComponents() override;
 
+	/* Return the primary asset id of Blueprint weapon classes */
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+
+	/* Primary asset type of Blueprint weapon classes */
+	static const FPrimaryAssetType PrimaryAssetType;
+
 protected:
 
 	/* Called when the game starts or when spawned */
@@ -51,8 +57,92 @@ protected:
 	class AZoneProjectCharacter* Character = nullptr;
 
 	/* rate of spawning projectiles */
-	UPROPERTY(Category = "Stats", BlueprintReadOnly)
+	UPROPERTY(Category = "Stats", BlueprintReadOnly, EditDefaultsOnly, Meta = (ClampMin = "0.01", UIMin = "0.01", ForceUnits = "s"))
 	float FireRate = 0.1f;
+
+	/* Defines how many shots a single trigger pull fires */
+	UPROPERTY(Category = "Stats", BlueprintReadOnly, EditDefaultsOnly)
+	EWeaponFireMode FireMode = EWeaponFireMode::Auto;
+
+	/* Number of shots fired by a single trigger pull in the burst mode */
+	UPROPERTY(Category = "Stats", BlueprintReadOnly, EditDefaultsOnly, Meta = (ClampMin = "1", UIMin = "1", EditCondition = "FireMode == EWeaponFireMode::Burst"))
+	int32 BurstCount = 3;
+
+	/* Maximum number of overdue shots fired at once when a burst becomes known late, older ones are skipped */
+	UPROPERTY(Category = "Stats", BlueprintReadOnly, EditDefaultsOnly, Meta = (ClampMin = "1", UIMin = "1"))
+	int32 MaxReplayedShots = 3;
+
+	/* Half-angle of the cone the shots are randomly spread in */
+	UPROPERTY(Category = "Stats", BlueprintReadOnly, EditDefaultsOnly, Meta = (ClampMin = "0", UIMin = "0", ForceUnits = "deg"))
+	float SpreadAngle = 0.f;
+
+	/* Cosmetic projectile class launched on clients */
+	UPROPERTY(Category = "Projectile", BlueprintReadOnly, EditDefaultsOnly)
+	TSubclassOf<class AZoneProjectProjectile> ProjectileClass;
+
+	/* Damage-dealing projectile class launched on the server */
+	UPROPERTY(Category = "Projectile", BlueprintReadOnly, EditDefaultsOnly)
+	TSubclassOf<class AZoneProjectProjectile> DamageProjectileClass;
+
+	/* Let the owning client register hits and validate them on the server by rewinding the hitboxes */
+	UPROPERTY(Category = "Projectile", BlueprintReadOnly, EditDefaultsOnly)
+	bool bUseLagCompensation = true;
+
+	/* Simulate projectiles in the batched projectile manager instead of launching pooled actors */
+	UPROPERTY(Category = "Projectile", BlueprintReadOnly, EditDefaultsOnly)
+	bool bUseProjectileManager = false;
+
+	/* Mesh socket the projectiles are launched from */
+	UPROPERTY(Category = "Projectile", BlueprintReadOnly, EditDefaultsOnly)
+	FName MuzzleSocketName = FName(TEXT("Muzzle"));
+
+	/* Return the projectile class to launch on this machine */
+	TSubclassOf<AZoneProjectProjectile> GetProjectileClass() const;
+
+	/* Fire state replicated to simulated proxies instead of per-shot RPCs */
+	UPROPERTY(Category = "Weapon", BlueprintReadOnly, ReplicatedUsing = OnRep_FireState)
+	FWeaponFireState FireState;
+
+	/* Fire scheduler state */
+
+	/* Indicates whether the trigger of the current burst is held */
+	bool bTriggerHeld = false;
+
+	/* Number of shots left in the current burst (INDEX_NONE for unlimited) */
+	int32 ShotsRemaining = 0;
+
+	/* Index of the next shot in the current burst, used to seed the spread */
+	int32 ShotIndex = 0;
+
+	/* World time the next shot is scheduled for. Advanced by exactly @FireRate per shot so the rate never drifts */
+	double NextShotTime = 0.0;
+
+	/* Called when the fire state is replicated */
+	UFUNCTION() void OnRep_FireState();
+
+	/* Mark the fire state for replication and wake the dormant channel up for it (server only) */
+	void MarkFireStateDirty();
+
+	/* Start scheduling the shots of a burst that started @Elapsed seconds ago */
+	void BeginBurst(const float Elapsed);
+
+	/* Release the trigger of the current burst */
+	void EndBurst();
+
+	/* Fire every shot that is due by the current world time */
+	void UpdateFireSchedule();
+
+	/* Fire a single shot that was due @LateBy seconds ago */
+	void FireShot(const float LateBy);
+
+	/* Return the direction of the specified shot of the current burst */
+	FRotator GetShotRotation(const int32 Index) const;
+
+	/* Launch a projectile advanced by the time the shot was late */
+	AZoneProjectProjectile* LaunchProjectile(const FRotator Rotation, const float LateBy);
+
+	/* Replicate a new firing state from the locally controlled shooter */
+	void SetFiring(const bool bFiring);
 	
 public:
 
@@ -64,21 +154,38 @@ public:
 
 	/* Return the instigator character actor */
 	AZoneProjectCharacter* GetCharacter() const { return Character; }
-	
-	/* Blueprint implementable events */
 
-	UFUNCTION(Category = "Weapon", BlueprintImplementableEvent, BlueprintCallable)
-	void StartFire();
+	/* Return the rate of spawning projectiles */
+	float GetFireRate() const { return FireRate; }
 
-	UFUNCTION(Category = "Weapon", BlueprintImplementableEvent, BlueprintCallable)
-	void ContinueFire();
+	/* Check whether the trigger is held */
+	bool IsFiring() const { return FireState.bFiring; }
 
-	UFUNCTION(Category = "Weapon", BlueprintImplementableEvent, BlueprintCallable)
+	/* Return the damage of a single projectile */
+	float GetProjectileDamage() const;
+
+	/* Return the maximum distance a projectile can travel */
+	float GetProjectileRange() const;
+
+	/* Forward a hit of a locally predicted projectile to the server when lag compensation is enabled */
+	void ReportHit(AActor* HitActor, const FVector& Origin, const FVector& Direction) const;
+
+	/* Launch a projectile from the muzzle socket in the specified direction. Returns null for batched projectiles */
+	UFUNCTION(Category = "Weapon", BlueprintCallable)
+	AZoneProjectProjectile* SpawnProjectile(const FRotator Rotation);
+	
+	/* Pull the trigger */
+	UFUNCTION(Category = "Weapon", BlueprintCallable)
+	void StartFire();
+
+	/* Release the trigger */
+	UFUNCTION(Category = "Weapon", BlueprintCallable)
 	void StopFire();
 
+	/* Cosmetic hook called for every shot on every machine except a dedicated server (muzzle flash, sound) */
 	UFUNCTION(Category = "Weapon", BlueprintImplementableEvent, BlueprintCallable)
 	void SimulateFire(const FRotator Rotation);
 
-	UFUNCTION(Category = "Weapon", BlueprintCallable)
-	void ReplicateFire(const FRotator Rotation);
+	UFUNCTION(Server, Reliable)
+	void ServerSetFireState(const FWeaponFireState& NewFireState);
 };
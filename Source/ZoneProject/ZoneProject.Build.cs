@@ -8,6 +8,6 @@ public class ZoneProject : ModuleRules
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
-        PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "NavigationSystem", "AIModule", "Niagara", "EnhancedInput" });
+        PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "NetCore", "InputCore", "NavigationSystem", "AIModule", "Niagara", "EnhancedInput", "StateTreeModule", "GameplayStateTreeModule", "AnimationBudgetAllocator", "AnimationSharing", "ReplicationGraph", "OnlineSubsystemUtils" });
     }
 }
@@ -1,9 +1,22 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "ZoneProject.h"
+#include "Misc/PackageName.h"
 #include "Modules/ModuleManager.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, ZoneProject, "ZoneProject" );
 
 DEFINE_LOG_CATEGORY(LogZoneProject)
+
+FPrimaryAssetId GetBlueprintPrimaryAssetId(const UObject* Object, const FPrimaryAssetType& Type)
+{
+	// Only the defaults of Blueprint classes are primary assets, native classes and instances are not
+
+	if (Object && Object->HasAnyFlags(RF_ClassDefaultObject) && !Object->GetClass()->HasAnyClassFlags(CLASS_Native))
+	{
+		return FPrimaryAssetId(Type, FPackageName::GetShortFName(Object->GetOutermost()->GetFName()));
+	}
+
+	return FPrimaryAssetId();
+}
  
\ No newline at end of file
@@ -3,9 +3,16 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "UObject/PrimaryAssetId.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogZoneProject, Log, All);
 
+DECLARE_STATS_GROUP(TEXT("ZoneProject"), STATGROUP_ZoneProject, STATCAT_Advanced);
+DECLARE_STATS_GROUP(TEXT("ZoneProject Net"), STATGROUP_ZoneProjectNet, STATCAT_Advanced);
+
+/* Return the primary asset id of the defaults of a Blueprint class, named after its package. Other objects have none */
+ZONEPROJECT_API FPrimaryAssetId GetBlueprintPrimaryAssetId(const UObject* Object, const FPrimaryAssetType& Type);
+
 /**
  * Area Event
  */
@@ -16,3 +23,75 @@ enum class EDropItemType : uint8
 	Health              UMETA(DisplayName = "Health"),
 	Max                 UMETA(Hidden)
 };
+
+/**
+ * Projectile pool overflow policy
+ */
+UENUM(BlueprintType)
+enum class EProjectilePoolOverflow : uint8
+{
+	Grow                UMETA(DisplayName = "Grow"),
+	RecycleOldest       UMETA(DisplayName = "Recycle Oldest"),
+	Reject              UMETA(DisplayName = "Reject")
+};
+
+/**
+ * Weapon fire mode
+ */
+UENUM(BlueprintType)
+enum class EWeaponFireMode : uint8
+{
+	Auto                UMETA(DisplayName = "Auto"),
+	Burst               UMETA(DisplayName = "Burst"),
+	Semi                UMETA(DisplayName = "Semi")
+};
+
+/**
+ * Custom movement modes of the character movement component
+ */
+UENUM(BlueprintType)
+enum ECustomMovementMode : uint8
+{
+	CMOVE_None          UMETA(Hidden),
+	CMOVE_Horde         UMETA(DisplayName = "Horde"),
+	CMOVE_Max           UMETA(Hidden)
+};
+
+/**
+ * Categories of actors indexed by the spatial hash
+ */
+UENUM(BlueprintType, Meta = (Bitflags, UseEnumValuesAsMaskValuesInEditor = "true"))
+enum class ESpatialCategory : uint8
+{
+	None                = 0 UMETA(Hidden),
+	Character           = 1 << 0 UMETA(DisplayName = "Character"),
+	DropItem            = 1 << 1 UMETA(DisplayName = "Drop Item"),
+	Projectile          = 1 << 2 UMETA(DisplayName = "Projectile"),
+	All                 = 0xFF UMETA(Hidden)
+};
+ENUM_CLASS_FLAGS(ESpatialCategory);
+
+/**
+ * Locomotion states in which distant characters share animation poses
+ */
+UENUM(BlueprintType)
+enum class EAnimationSharingState : uint8
+{
+	Idle                UMETA(DisplayName = "Idle"),
+	Walk                UMETA(DisplayName = "Walk"),
+	Run                 UMETA(DisplayName = "Run"),
+	Fall                UMETA(DisplayName = "Fall")
+};
+
+/**
+ * Character state replicated as a single byte
+ */
+UENUM(BlueprintType, Meta = (Bitflags, UseEnumValuesAsMaskValuesInEditor = "true"))
+enum class ECharacterStateFlags : uint8
+{
+	None                = 0 UMETA(Hidden),
+	Dead                = 1 << 0 UMETA(DisplayName = "Dead"),
+	Sprinting           = 1 << 1 UMETA(DisplayName = "Sprinting"),
+	Dormant             = 1 << 2 UMETA(DisplayName = "Dormant")
+};
+ENUM_CLASS_FLAGS(ECharacterStateFlags);
@@ -10,6 +10,7 @@ public class ZoneProjectEditorTarget : TargetRules
 		Type = TargetType.Editor;
 		DefaultBuildSettings = BuildSettingsVersion.V5;
 		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_4;
+		bWithPushModel = true;
 		ExtraModuleNames.Add("ZoneProject");
 	}
 }